@@ -21,6 +21,7 @@
 #include <fstream>
 #include <iomanip>
 #include <string>
+#include <vector>
 
 #include <yarp/os/Network.h>
 #include <yarp/os/RFModule.h>
@@ -29,8 +30,13 @@
 #include <yarp/sig/Vector.h>
 #include <yarp/os/Vocab.h>
 #include <yarp/math/Math.h>
+#include <yarp/os/Mutex.h>
 #include <yarp/conf/system.h>
 
+#include "normalization.h"
+#include "wireVector.h"
+#include "shmRing.h"
+
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::sig;
@@ -42,15 +48,17 @@ class Normalizer: public RFModule
 protected:
     
     // Ports
-    BufferedPort<Bottle>      outFeatures;
-    BufferedPort<Bottle>      inFeatures;
+    BufferedPort<wireVector>  outFeatures;
+    BufferedPort<wireVector>  inFeatures;
     Port                      rpcPort;
+    shmRingChannel            shmOut;   // Shared memory output to a co-located RFmapper
     
     // Data
     int d;
     int t;
-    Bottle maxes;      // Max limits
-    Bottle mins;       // Min limits
+    normalization norm;     // Normalization type and statistics
+    Mutex normMutex;        // Protects norm from concurrent RPC commands
+    string statsPath;       // Statistics file, loaded at startup and saved on close
     
 public:
     /************************************************************************/
@@ -73,8 +81,76 @@ public:
             reply.addVocab(Vocab::encode("many"));
             reply.addString("Available commands are:");
             reply.addString("help");
+            reply.addString("stats");
+            reply.addString("save [file]");
+            reply.addString("load [file]");
+            reply.addString("reset");
+            reply.addString("apply (inputs) ...");
             reply.addString("quit");
         }
+        else if (receivedCmd == "stats")
+        {
+            // Reply with the number of samples and the current scaling
+            normMutex.lock();
+            reply.addString(norm.type.c_str());
+            reply.addInt((int)norm.n);
+            Bottle &scaleB = reply.addList();
+            Bottle &offsetB = reply.addList();
+            for (int i = 0 ; i < d ; ++i)
+            {
+                scaleB.addDouble(norm.scale[i]);
+                offsetB.addDouble(norm.offset[i]);
+            }
+            normMutex.unlock();
+            getWireStats().report(reply);
+        }
+        else if (receivedCmd == "save" || receivedCmd == "load")
+        {
+            string fileName = command.size() > 1 ? command.get(1).asString().c_str() : statsPath;
+            if (fileName == "")
+                reply.addString("No statistics file specified.");
+            else
+            {
+                normMutex.lock();
+                bool ok = receivedCmd == "save" ? norm.save(fileName) : norm.load(fileName);
+                normMutex.unlock();
+                reply.addString(ok ? "ok" : "failed");
+                reply.addString(fileName.c_str());
+            }
+        }
+        else if (receivedCmd == "apply")
+        {
+            // Normalize each list of d inputs with the current statistics,
+            // which are not updated (e.g. candidate configurations of the
+            // RandMotion exploration)
+            vector<double> x(d), y(d);
+            normMutex.lock();
+            for (int j = 1 ; j < command.size() ; ++j)
+            {
+                Bottle *inputs = command.get(j).asList();
+                if (inputs == 0 || inputs->size() != d)
+                {
+                    reply.clear();
+                    reply.addString("Invalid input vectors.");
+                    break;
+                }
+                for (int i = 0 ; i < d ; ++i)
+                    x[i] = inputs->get(i).asDouble();
+                norm.apply(&x[0], &y[0]);
+
+                Bottle &normB = reply.addList();
+                for (int i = 0 ; i < d ; ++i)
+                    normB.addDouble(y[i]);
+            }
+            normMutex.unlock();
+        }
+        else if (receivedCmd == "reset")
+        {
+            normMutex.lock();
+            norm.reset(d);
+            normMutex.unlock();
+            reply.addString("Statistics reset.");
+        }
         else if (receivedCmd == "quit")
         {
             reply.addString("Quitting.");
@@ -101,29 +177,53 @@ public:
             return false;
         }
         
-        // Get fixed limits
-        
-        maxes = rf.findGroup("LIMITS").findGroup("Max").tail();
-        mins = rf.findGroup("LIMITS").findGroup("Min").tail();
-        if (maxes.size() != mins.size())
-        {
-            printf("Error: Inconsistent limits dimensionalities!\n");
+        // Set normalization type, parameters and limits
+        if (!norm.configure(rf, d))
             return false;
+
+        // Load the statistics exported by a previous run, if any
+        if (norm.type != "fixed" && rf.check("statsFile"))
+        {
+            string statsFile = rf.find("statsFile").asString().c_str();
+            statsPath = rf.getHomeContextPath() + "/" + statsFile;
+            string found = rf.findFile(statsFile.c_str()).c_str();
+            if (found != "" && norm.load(found))
+                cout << "Statistics of " << norm.n << " samples loaded from " << found << endl;
+            else
+                cout << "No statistics loaded, starting from scratch" << endl;
         }
+
         
         // Print Configuration
         cout << endl << "-------------------------" << endl;
         cout << "Configuration parameters:" << endl << endl;
         cout << "d = " << d << endl;
         cout << "t = " << t << endl;
-        printf("Limits:\n");
-        for (int i=0; i<maxes.size(); i++) {
-            printf("%d)  " , i);
-            printf("Min: %d\t", mins.get(i).asInt());
-            printf("Max: %d\n", maxes.get(i).asInt());
+        cout << "Type = " << norm.type << endl;
+        if (norm.type == "running")
+            cout << "decay = " << norm.decay << endl;
+        if (norm.type == "frozen")
+            cout << "warmup = " << norm.warmup << endl;
+        if (norm.type != "zscore")
+        {
+            printf("Limits:\n");
+            for (int i=0; i<d; i++) {
+                printf("%d)  " , i);
+                printf("Min: %g\t", norm.minV[i]);
+                printf("Max: %g\n", norm.maxV[i]);
+            }
         }
         cout << "-------------------------" << endl << endl;
        
+        // Optional shared memory output, created by the consumer
+        if (rf.check("shmOutput"))
+        {
+            string ring = rf.find("shmOutput").asString().c_str();
+            if (!shmOut.openProducer(ring, rf.check("shmTimeout",Value(1.0)).asDouble()))
+                return false;
+            cout << "Writing features to shared memory ring " << ring << endl;
+        }
+
         // Open ports
         string fwslash="/";
         inFeatures.open((fwslash+name+"/features:i").c_str());
@@ -142,6 +242,17 @@ public:
     /************************************************************************/
     bool close()
     {        
+        // Export the statistics for the next run
+        if (statsPath != "")
+        {
+            if (norm.save(statsPath))
+                cout << "Statistics saved to " << statsPath << endl;
+            else
+                cout << "Warning: could not save statistics to " << statsPath << endl;
+        }
+
+        shmOut.close();
+
         // Close ports
         inFeatures.close();
         printf("inFeatures port closed\n");
@@ -170,29 +281,34 @@ public:
     {
 
         // Wait for input feature vector
-        Bottle *bin = inFeatures.read();    // blocking call
+        wireVector *bin = inFeatures.read();    // blocking call
 
         if (bin != 0)
         {
-        Bottle& bout = outFeatures.prepare(); // Get a place to store things.
-        bout.clear();  // clear is important - b might be a reused object
-
-            // Apply scaling of incoming features
-            for (int i = 0 ; i < d + t ; ++i)
+            if (bin->size() < d + t)
             {
-
-                if (i<d)        // Add normalized features
-                {
-                    if (bin->get(i).asDouble() < mins.get(i).asDouble())
-                        bout.add(0.0);
-                    else if (bin->get(i).asDouble() > maxes.get(i).asDouble())
-                        bout.add(1.0);
-                    else
-                        bout.add( ( bin->get(i).asDouble() - mins.get(i).asDouble() ) / (maxes.get(i).asDouble() - mins.get(i).asDouble() ) );
-                }
-                else            // Add labels
-                    bout.add(bin->get(i).asDouble());   
+                printf("Error: Received %d elements, %d expected!\n", bin->size(), d + t);
+                return true;
             }
+
+            const double *x = bin->data.data();
+
+            wireVector &bout = outFeatures.prepare(); // Get a place to store things.
+            bout.data.resize(d + t);
+            double *xn = bout.data.data();
+
+            // Update the statistics and apply scaling of incoming features
+            normMutex.lock();
+            norm.update(x);
+            norm.apply(x, xn);
+            normMutex.unlock();
+
+            // Copy labels
+            for (int i = d ; i < d + t ; ++i)
+                xn[i] = x[i];
+
+            if (shmOut.isActive())
+                shmOut.write(xn, d + t);
             outFeatures.write();
         }
 
@@ -208,6 +324,7 @@ public:
         // Interrupt any blocking reads on the output port
         outFeatures.interrupt();
         printf("outFeatures port interrupted\n");
+        shmOut.interrupt();
 
         // Interrupt any blocking reads on the rpc port        
         rpcPort.interrupt();
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _NORMALIZATION
+#define _NORMALIZATION
+
+#include <fstream>
+#include <string>
+#include <cmath>
+#include <cstdio>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Value.h>
+#include <yarp/sig/Vector.h>
+
+/************************************************************************/
+// Branch-free clamp-and-scale kernel: y = min(max(x * scale + offset, 0), 1).
+// The loop has no data dependent branches, so that the compiler can
+// vectorize it (min/max instructions).
+inline void clampScale(const double *x, const double *scale, const double *offset, double *y, int n)
+{
+    for (int i = 0 ; i < n ; ++i)
+    {
+        double v = x[i] * scale[i] + offset[i];
+        v = v > 0.0 ? v : 0.0;
+        y[i] = v < 1.0 ? v : 1.0;
+    }
+}
+
+/************************************************************************/
+// Affine scaling kernel without clamping: y = x * scale + offset
+inline void affineScale(const double *x, const double *scale, const double *offset, double *y, int n)
+{
+    for (int i = 0 ; i < n ; ++i)
+        y[i] = x[i] * scale[i] + offset[i];
+}
+
+/************************************************************************/
+// Per-feature normalization with fixed or online statistics.
+// All the types cost O(d) per sample:
+//  fixed   - min-max scaling to [0, 1] with the configured limits
+//  zscore  - (x - mean) / std, with running mean and variance (Welford)
+//  running - min-max scaling to [0, 1] with running limits, which shrink
+//            towards each other by a fraction 'decay' of the range at each
+//            sample, so that they track a moving operating range
+//  frozen  - min-max scaling to [0, 1] with the limits observed during the
+//            first 'warmup' samples, fixed afterwards
+class normalization
+{
+public:
+    std::string type;
+    int     d;
+    double  decay;          // Shrinking rate of the running limits
+    int     warmup;         // Number of samples before freezing the limits
+    double  minStd;         // Lower bound of the standard deviation (zscore)
+
+    long    n;              // Number of samples seen
+    bool    hasLimits;      // The running limits start from the configured ones
+    yarp::sig::Vector mean;
+    yarp::sig::Vector m2;   // Sum of squared deviations from the mean
+    yarp::sig::Vector minV;
+    yarp::sig::Vector maxV;
+
+    yarp::sig::Vector scale;    // Current scaling, precomputed from the statistics
+    yarp::sig::Vector offset;
+
+    yarp::os::Bottle limitMins;     // Configured limits, empty if none
+    yarp::os::Bottle limitMaxes;
+
+    normalization() : type("fixed"), d(0), decay(1e-4), warmup(1000), minStd(1e-6), n(0), hasLimits(false)
+    {
+    }
+
+    bool isValidType() const
+    {
+        return type == "fixed" || type == "zscore" || type == "running" || type == "frozen";
+    }
+
+    // True when the statistics are updated by incoming samples
+    bool isAdaptive() const
+    {
+        return type == "zscore" || type == "running" || (type == "frozen" && n < warmup);
+    }
+
+    // Set up type, parameters and limits from the configuration of Normalizer
+    bool configure(const yarp::os::Searchable &cfg, int dim)
+    {
+        type = cfg.check("Type",yarp::os::Value("fixed")).asString().c_str();
+        if (!isValidType())
+        {
+            printf("Error: Normalization type not available!\n");
+            return false;
+        }
+        decay = cfg.check("decay",yarp::os::Value(1e-4)).asDouble();
+        warmup = cfg.check("warmup",yarp::os::Value(1000)).asInt();
+
+        // Get limits, required by the fixed type, optional initial limits of the running type.
+        // They are kept to be applied again by reset()
+        limitMaxes = cfg.findGroup("LIMITS").findGroup("Max").tail();
+        limitMins = cfg.findGroup("LIMITS").findGroup("Min").tail();
+        if (type == "fixed" || (type == "running" && limitMaxes.size() > 0))
+        {
+            if (limitMaxes.size() != dim || limitMins.size() != dim)
+            {
+                printf("Error: Inconsistent limits dimensionalities!\n");
+                return false;
+            }
+        }
+        else
+        {
+            limitMaxes.clear();
+            limitMins.clear();
+        }
+
+        reset(dim);
+        if (limitMaxes.size() > 0 && !hasLimits)
+        {
+            printf("Error: Max limits must be greater than Min limits!\n");
+            return false;
+        }
+        return true;
+    }
+
+    // Reset the statistics, back to the configured limits if any
+    void reset(int dim)
+    {
+        d = dim;
+        n = 0;
+        hasLimits = false;
+        mean.resize(d);
+        m2.resize(d);
+        minV.resize(d);
+        maxV.resize(d);
+        scale.resize(d);
+        offset.resize(d);
+        mean.zero();
+        m2.zero();
+        minV.zero();
+        maxV.zero();
+        if (limitMaxes.size() > 0 && setLimits(limitMins, limitMaxes))
+            return;
+        updateScaling();
+    }
+
+    // Set the limits of the fixed type and the initial limits of the running
+    // type (the frozen type always starts from the data). Returns false if a
+    // Max limit is not greater than the corresponding Min limit.
+    bool setLimits(const yarp::os::Bottle &mins, const yarp::os::Bottle &maxes)
+    {
+        for (int i = 0 ; i < d ; ++i)
+        {
+            minV[i] = mins.get(i).asDouble();
+            maxV[i] = maxes.get(i).asDouble();
+            if (maxV[i] <= minV[i])
+                return false;
+        }
+        n = 0;
+        hasLimits = true;
+        updateScaling();
+        return true;
+    }
+
+    // Update the statistics with a new sample of d features
+    void update(const double *x)
+    {
+        if (!isAdaptive())
+            return;
+
+        ++n;
+        if (type == "zscore")
+        {
+            for (int i = 0 ; i < d ; ++i)
+            {
+                double delta = x[i] - mean[i];
+                mean[i] += delta / n;
+                m2[i] += delta * (x[i] - mean[i]);
+            }
+        }
+        else if (n == 1 && (type == "frozen" || !hasLimits))
+        {
+            for (int i = 0 ; i < d ; ++i)
+                minV[i] = maxV[i] = x[i];
+        }
+        else
+        {
+            double rate = type == "running" ? decay : 0.0;
+            for (int i = 0 ; i < d ; ++i)
+            {
+                double shrink = rate * (maxV[i] - minV[i]);
+                double lo = minV[i] + shrink;
+                double hi = maxV[i] - shrink;
+                minV[i] = x[i] < lo ? x[i] : lo;
+                maxV[i] = x[i] > hi ? x[i] : hi;
+            }
+        }
+        updateScaling();
+    }
+
+    // Recompute scale and offset from the current statistics
+    void updateScaling()
+    {
+        if (type == "zscore")
+        {
+            for (int i = 0 ; i < d ; ++i)
+            {
+                double sd = n > 1 ? sqrt(m2[i] / (n - 1)) : 1.0;
+                sd = sd > minStd ? sd : minStd;
+                scale[i] = 1.0 / sd;
+                offset[i] = -mean[i] / sd;
+            }
+        }
+        else
+        {
+            // A degenerate range maps to 0 until the limits separate
+            for (int i = 0 ; i < d ; ++i)
+            {
+                double range = maxV[i] - minV[i];
+                scale[i] = range > 0.0 ? 1.0 / range : 0.0;
+                offset[i] = -minV[i] * scale[i];
+            }
+        }
+    }
+
+    // Normalize d features
+    void apply(const double *x, double *y) const
+    {
+        if (type == "zscore")
+            affineScale(x, scale.data(), offset.data(), y, d);
+        else
+            clampScale(x, scale.data(), offset.data(), y, d);
+    }
+
+    // Export the statistics in a configuration file readable by load()
+    bool save(const std::string &fileName) const
+    {
+        std::ofstream ofs(fileName.c_str());
+        if (!ofs.is_open())
+            return false;
+
+        ofs.precision(17);
+        ofs << "Type " << type << std::endl;
+        ofs << "d " << d << std::endl;
+        ofs << "n " << n << std::endl;
+        saveVector(ofs, "Mean", mean);
+        saveVector(ofs, "M2", m2);
+        saveVector(ofs, "Min", minV);
+        saveVector(ofs, "Max", maxV);
+        return ofs.good();
+    }
+
+    // Load statistics exported by save(). The type and dimensionality must
+    // match the current ones.
+    bool load(const std::string &fileName)
+    {
+        yarp::os::Property p;
+        if (!p.fromConfigFile(fileName.c_str()))
+            return false;
+
+        if (p.find("Type").asString().c_str() != type || p.find("d").asInt() != d)
+            return false;
+
+        yarp::os::Bottle meanB = p.findGroup("Mean").tail();
+        yarp::os::Bottle m2B = p.findGroup("M2").tail();
+        yarp::os::Bottle minB = p.findGroup("Min").tail();
+        yarp::os::Bottle maxB = p.findGroup("Max").tail();
+        if (meanB.size() != d || m2B.size() != d || minB.size() != d || maxB.size() != d)
+            return false;
+
+        n = p.find("n").asInt();
+        hasLimits = true;
+        for (int i = 0 ; i < d ; ++i)
+        {
+            mean[i] = meanB.get(i).asDouble();
+            m2[i] = m2B.get(i).asDouble();
+            minV[i] = minB.get(i).asDouble();
+            maxV[i] = maxB.get(i).asDouble();
+        }
+        updateScaling();
+        return true;
+    }
+
+private:
+    static void saveVector(std::ofstream &ofs, const char *key, const yarp::sig::Vector &v)
+    {
+        ofs << key;
+        for (size_t i = 0 ; i < v.size() ; ++i)
+            ofs << " " << v[i];
+        ofs << std::endl;
+    }
+};
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+\defgroup PVAevaluator
+
+Offline comparison of the velocity and acceleration estimators of Synchronizer.
+
+Copyright (C) 2014 RobotCub Consortium
+
+Author: Raffaello Camoriano
+
+CopyPolicy: Released under the terms of the GNU GPL v2.0.
+
+\section intro_sec Description
+Loads recorded joint positions whose rows are [ time , q ], with xsz joints,
+and runs each derivative estimator (aw, sg, kalman) on them as Synchronizer
+would. The estimates are compared with a non-causal reference, a quadratic
+least squares fit centered on each sample over +-refHalfWindow samples.
+For velocity and acceleration the tool reports the lag, i.e. the delay
+in samples (up to maxLag) which best matches the estimate with the
+reference, the RMS error at that lag (noise) and the RMS error without
+delay compensation, averaged over the joints, together with the average
+estimation time per sample.
+
+\author Raffaello Camoriano
+*/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include <cmath>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+
+#include "pvaEstimator.h"
+#include "sampleFile.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+
+/************************************************************************/
+// Reference derivatives of joint j at sample i: quadratic least squares fit
+// on the samples [i - h, i + h], with the actual timestamps
+bool referenceDerivatives(const vector<Vector> &samples, int i, int j, int h, double &vel, double &acc)
+{
+    double S[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };     // sum of tau^k
+    double R[3] = { 0.0, 0.0, 0.0 };               // sum of tau^k * q
+    double t0 = samples[i][0];
+    for (int k = i - h ; k <= i + h ; ++k)
+    {
+        double tau = samples[k][0] - t0;
+        double q = samples[k][1 + j];
+        double p = 1.0;
+        for (int e = 0 ; e < 5 ; ++e)
+        {
+            if (e < 3)
+                R[e] += p * q;
+            S[e] += p;
+            p *= tau;
+        }
+    }
+
+    // Normal equations [S0 S1 S2 ; S1 S2 S3 ; S2 S3 S4] c = R, by Cramer's rule
+    double det = S[0] * (S[2] * S[4] - S[3] * S[3]) - S[1] * (S[1] * S[4] - S[3] * S[2]) + S[2] * (S[1] * S[3] - S[2] * S[2]);
+    if (fabs(det) < 1e-300)
+        return false;
+    double det1 = S[0] * (R[1] * S[4] - S[3] * R[2]) - R[0] * (S[1] * S[4] - S[3] * S[2]) + S[2] * (S[1] * R[2] - R[1] * S[2]);
+    double det2 = S[0] * (S[2] * R[2] - R[1] * S[3]) - S[1] * (S[1] * R[2] - R[1] * S[2]) + R[0] * (S[1] * S[3] - S[2] * S[2]);
+    vel = det1 / det;
+    acc = 2.0 * det2 / det;
+    return true;
+}
+
+/************************************************************************/
+// RMS difference between est[i] and ref[i - lag] over the valid range
+double rmsAtLag(const vector<double> &est, const vector<double> &ref, const vector<bool> &valid, int first, int lag)
+{
+    double sum = 0.0;
+    int n = 0;
+    for (int i = first + lag ; i < (int)est.size() ; ++i)
+    {
+        if (!valid[i - lag])
+            continue;
+        double e = est[i] - ref[i - lag];
+        sum += e * e;
+        ++n;
+    }
+    return n > 0 ? sqrt(sum / n) : 0.0;
+}
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultConfigFile("PVAevaluator_config.ini");
+    rf.setDefaultContext("iRRLS");
+    rf.configure(argc,argv);
+
+    Bottle &general = rf.findGroup("general");
+    int xsz = general.check("xsz",Value(4)).asInt();
+    int h = general.check("refHalfWindow",Value(15)).asInt();
+    int maxLag = general.check("maxLag",Value(20)).asInt();
+    int warmup = general.check("warmup",Value(50)).asInt();
+    string dataFile = general.check("dataFile",Value("positions.dat")).asString().c_str();
+
+    Bottle estimators;
+    if (general.find("estimators").isList())
+        estimators = *general.find("estimators").asList();
+    else
+        estimators.fromString("aw sg kalman");
+
+    if (xsz <= 0 || h < 2 || maxLag < 0 || warmup < 0)
+    {
+        printf("Error: Inconsistent parameters!\n");
+        return -1;
+    }
+
+    // Load the recorded positions
+    string dataPath = rf.getContextPath() + "/data/" + dataFile;
+    vector<Vector> samples;
+    if (!loadSamples(dataPath, 1 + xsz, samples))
+    {
+        printf("Error: Could not open %s!\n", dataPath.c_str());
+        return -1;
+    }
+    int n = (int)samples.size();
+    if (n < 2 * h + 1 + warmup + maxLag)
+    {
+        printf("Error: %s contains %d samples, too few for the reference and the lag search!\n", dataPath.c_str(), n);
+        return -1;
+    }
+    cout << "Loaded " << n << " samples from " << dataPath << endl;
+    double period = (samples[n - 1][0] - samples[0][0]) / (n - 1);
+
+    // Reference derivatives, not available on the first and last h samples
+    vector<vector<double> > refVel(xsz, vector<double>(n, 0.0));
+    vector<vector<double> > refAcc(xsz, vector<double>(n, 0.0));
+    vector<bool> valid(n, false);
+    for (int i = h ; i < n - h ; ++i)
+    {
+        valid[i] = true;
+        for (int j = 0 ; j < xsz ; ++j)
+            valid[i] = referenceDerivatives(samples, i, j, h, refVel[j][i], refAcc[j][i]) && valid[i];
+    }
+
+    cout << endl << "-------------------------" << endl;
+    cout << "Reference: centered quadratic fit over " << 2 * h + 1 << " samples" << endl;
+    cout << "Average sample period: " << 1000.0 * period << " ms" << endl;
+    cout << "-------------------------" << endl;
+    cout << setw(10) << "estimator" << setw(12) << "time [us]"
+         << setw(12) << "vel lag[ms]" << setw(12) << "vel noise" << setw(12) << "vel RMSE"
+         << setw(12) << "acc lag[ms]" << setw(12) << "acc noise" << setw(12) << "acc RMSE" << endl;
+
+    for (int e = 0 ; e < estimators.size() ; ++e)
+    {
+        string type = estimators.get(e).asString().c_str();
+
+        // Estimator parameters from the general group, as Synchronizer reads them
+        Property cfg(general.toString().c_str());
+        cfg.put("derivEstimator", type.c_str());
+        pvaEstimator estimator(cfg);
+        if (estimator.getType() != type)
+        {
+            // Unknown names fall back to the default estimator
+            printf("Warning: Unknown estimator %s, skipped!\n", type.c_str());
+            continue;
+        }
+
+        vector<vector<double> > vel(xsz, vector<double>(n, 0.0));
+        vector<vector<double> > acc(xsz, vector<double>(n, 0.0));
+        Vector q(xsz), qdot, qdotdot;
+
+        double t0 = Time::now();
+        for (int i = 0 ; i < n ; ++i)
+        {
+            for (int j = 0 ; j < xsz ; ++j)
+                q[j] = samples[i][1 + j];
+            estimator.estimate(q, samples[i][0], qdot, qdotdot);
+            for (int j = 0 ; j < xsz ; ++j)
+            {
+                vel[j][i] = qdot[j];
+                acc[j][i] = qdotdot[j];
+            }
+        }
+        double cost = (Time::now() - t0) / n;
+
+        // Lag minimizing the RMS error, and the errors, averaged over the joints
+        double res[2][3];
+        for (int k = 0 ; k < 2 ; ++k)
+        {
+            const vector<vector<double> > &est = k == 0 ? vel : acc;
+            const vector<vector<double> > &ref = k == 0 ? refVel : refAcc;
+
+            int bestLag = 0;
+            double bestRMS = -1.0;
+            for (int lag = 0 ; lag <= maxLag ; ++lag)
+            {
+                double rms = 0.0;
+                for (int j = 0 ; j < xsz ; ++j)
+                    rms += rmsAtLag(est[j], ref[j], valid, warmup, lag) / xsz;
+                if (bestRMS < 0.0 || rms < bestRMS)
+                {
+                    bestRMS = rms;
+                    bestLag = lag;
+                }
+            }
+
+            double rms0 = 0.0;
+            for (int j = 0 ; j < xsz ; ++j)
+                rms0 += rmsAtLag(est[j], ref[j], valid, warmup, 0) / xsz;
+
+            res[k][0] = 1000.0 * bestLag * period;
+            res[k][1] = bestRMS;
+            res[k][2] = rms0;
+        }
+
+        cout << setw(10) << type << setw(12) << 1e6 * cost
+             << setw(12) << res[0][0] << setw(12) << res[0][1] << setw(12) << res[0][2]
+             << setw(12) << res[1][0] << setw(12) << res[1][1] << setw(12) << res[1][2] << endl;
+    }
+    cout << "-------------------------" << endl;
+
+    return 0;
+}
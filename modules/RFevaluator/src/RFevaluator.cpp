@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+\defgroup RFevaluator
+
+Offline comparison of random features sampling strategies.
+
+Copyright (C) 2014 RobotCub Consortium
+
+Author: Raffaello Camoriano
+
+CopyPolicy: Released under the terms of the GNU GPL v2.0.
+
+\section intro_sec Description
+Loads a recorded dataset whose rows are [ x , y ], with d inputs and t outputs,
+maps the inputs with the random features of RFmapper for each sampling sequence
+(Monte Carlo or quasi-Monte Carlo) and number of projections, trains a batch RLS
+model on the first n_tr samples and reports the average test RMSE on the following
+n_te samples. For each sequence, the smallest number of projections reaching the
+target RMSE is reported.
+
+\author Raffaello Camoriano
+*/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include <cmath>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Value.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Math.h>
+
+#include "randomFeatures.h"
+#include "sampleFile.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::math;
+
+/************************************************************************/
+// Solve (A + lambda*I) X = B in place (X overwrites B) by Cholesky factorization
+bool choleskySolve(Matrix &A, Matrix &B, double lambda)
+{
+    int n = A.rows();
+    for (int i = 0 ; i < n ; ++i)
+        A(i,i) += lambda;
+
+    // A = L L', L stored in the lower triangle of A
+    for (int j = 0 ; j < n ; ++j)
+    {
+        double s = A(j,j);
+        for (int k = 0 ; k < j ; ++k)
+            s -= A(j,k) * A(j,k);
+        if (s <= 0.0)
+            return false;
+        A(j,j) = sqrt(s);
+
+        for (int i = j + 1 ; i < n ; ++i)
+        {
+            double v = A(i,j);
+            for (int k = 0 ; k < j ; ++k)
+                v -= A(i,k) * A(j,k);
+            A(i,j) = v / A(j,j);
+        }
+    }
+
+    for (int c = 0 ; c < B.cols() ; ++c)
+    {
+        // Forward substitution L z = b
+        for (int i = 0 ; i < n ; ++i)
+        {
+            double v = B(i,c);
+            for (int k = 0 ; k < i ; ++k)
+                v -= A(i,k) * B(k,c);
+            B(i,c) = v / A(i,i);
+        }
+        // Backward substitution L' x = z
+        for (int i = n - 1 ; i >= 0 ; --i)
+        {
+            double v = B(i,c);
+            for (int k = i + 1 ; k < n ; ++k)
+                v -= A(k,i) * B(k,c);
+            B(i,c) = v / A(i,i);
+        }
+    }
+    return true;
+}
+
+/************************************************************************/
+// Map the samples [first, first + n) with the given random features
+void mapSamples(const randomFeatures &mapping, const vector<Vector> &samples,
+                int first, int n, Matrix &Phi)
+{
+    vector<Vector> batch(samples.begin() + first, samples.begin() + first + n);
+    Phi.resize(n, mapping.outDim());
+    mapping.mapRows(batch, n, Phi, 0, mapping.numRF);
+}
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultConfigFile("RFevaluator_config.ini");
+    rf.setDefaultContext("iRRLS");
+    rf.configure(argc,argv);
+
+    Bottle &general = rf.findGroup("general");
+    int d = general.check("d",Value(12)).asInt();
+    int t = general.check("t",Value(6)).asInt();
+    int n_tr = general.check("n_tr",Value(5000)).asInt();
+    int n_te = general.check("n_te",Value(5000)).asInt();
+    double lambda = general.check("lambda",Value(1e-6)).asDouble();
+    double targetRMSE = general.check("targetRMSE",Value(1.0)).asDouble();
+    int numSeeds = general.check("numSeeds",Value(5)).asInt();
+    int normalize = general.check("normalize",Value(1)).asInt();
+    string dataFile = general.check("dataFile",Value("icubdyn.dat")).asString().c_str();
+
+    randomFeatures base;
+    base.d = d;
+    base.mappingType = general.check("mappingType",Value(1)).asInt();
+    base.kernel = general.check("kernel",Value("gaussian")).asString().c_str();
+    base.sigma = general.check("sigma",Value(1.0)).asDouble();
+    base.nu = general.check("nu",Value(1.5)).asDouble();
+
+    Bottle numRFList;
+    Bottle sequences;
+    if (general.find("numRF").isList())
+        numRFList = *general.find("numRF").asList();
+    else
+        numRFList.fromString("50 100 200 500 1000");
+    if (general.find("sequence").isList())
+        sequences = *general.find("sequence").asList();
+    else
+        sequences.fromString("mc halton");
+
+    if (d <= 0 || t <= 0 || n_tr <= 0 || n_te <= 0 || numSeeds <= 0)
+    {
+        printf("Error: Inconsistent dimensionalities!\n");
+        return -1;
+    }
+
+    // Load the recorded data
+    string dataPath = rf.getContextPath() + "/data/" + dataFile;
+    vector<Vector> samples;
+    if (!loadSamples(dataPath, d + t, samples))
+    {
+        printf("Error: Could not open %s!\n", dataPath.c_str());
+        return -1;
+    }
+    if ((int)samples.size() < n_tr + n_te)
+    {
+        printf("Error: %s contains %d samples, %d required!\n", dataPath.c_str(), (int)samples.size(), n_tr + n_te);
+        return -1;
+    }
+    cout << "Loaded " << samples.size() << " samples from " << dataPath << endl;
+
+    // Scale the inputs to [0, 1] with the training set limits, as Normalizer does
+    if (normalize)
+    {
+        for (int l = 0 ; l < d ; ++l)
+        {
+            double minVal = samples[0][l];
+            double maxVal = samples[0][l];
+            for (int j = 1 ; j < n_tr ; ++j)
+            {
+                minVal = min(minVal, samples[j][l]);
+                maxVal = max(maxVal, samples[j][l]);
+            }
+            double range = maxVal > minVal ? maxVal - minVal : 1.0;
+            for (int j = 0 ; j < n_tr + n_te ; ++j)
+                samples[j][l] = min(max((samples[j][l] - minVal) / range, 0.0), 1.0);
+        }
+    }
+
+    Matrix Ytr(n_tr, t);
+    for (int j = 0 ; j < n_tr ; ++j)
+        for (int o = 0 ; o < t ; ++o)
+            Ytr(j,o) = samples[j][d + o];
+
+    cout << endl << "-------------------------" << endl;
+    cout << "Kernel: " << base.kernel << ", sigma = " << base.sigma << ", lambda = " << lambda << endl;
+    cout << "Target RMSE: " << targetRMSE << ", averaged over " << numSeeds << " seeds" << endl;
+    cout << "-------------------------" << endl;
+    cout << setw(10) << "sequence" << setw(10) << "numRF" << setw(16) << "avg RMSE" << endl;
+
+    vector<int> numRFToTarget(sequences.size(), -1);
+
+    for (int q = 0 ; q < sequences.size() ; ++q)
+    {
+        for (int r = 0 ; r < numRFList.size() ; ++r)
+        {
+            double avgRMSE = 0.0;
+
+            for (int seed = 0 ; seed < numSeeds ; ++seed)
+            {
+                randomFeatures mapping(base);
+                mapping.sequence = sequences.get(q).asString().c_str();
+                mapping.numRF = numRFList.get(r).asInt();
+                mapping.seed = seed;
+                if (!mapping.generateDense(0))
+                {
+                    printf("Error: Unknown sequence or kernel!\n");
+                    return -1;
+                }
+                if (mapping.mappingType == 2)
+                    mapping.generatePhases(0);
+
+                // Batch RLS on the training set
+                Matrix PhiTr;
+                mapSamples(mapping, samples, 0, n_tr, PhiTr);
+                Matrix A = PhiTr.transposed() * PhiTr;
+                Matrix Wrls = PhiTr.transposed() * Ytr;
+                if (!choleskySolve(A, Wrls, lambda * n_tr))
+                {
+                    printf("Error: Ill-conditioned problem, increase lambda!\n");
+                    return -1;
+                }
+
+                // Average RMSE over the outputs on the test set
+                Matrix PhiTe;
+                mapSamples(mapping, samples, n_tr, n_te, PhiTe);
+                Matrix Yhat = PhiTe * Wrls;
+                double rmse = 0.0;
+                for (int o = 0 ; o < t ; ++o)
+                {
+                    double mse = 0.0;
+                    for (int j = 0 ; j < n_te ; ++j)
+                    {
+                        double e = Yhat(j,o) - samples[n_tr + j][d + o];
+                        mse += e * e;
+                    }
+                    rmse += sqrt(mse / n_te);
+                }
+                avgRMSE += rmse / t;
+            }
+            avgRMSE /= numSeeds;
+
+            cout << setw(10) << sequences.get(q).asString().c_str() << setw(10) << numRFList.get(r).asInt()
+                 << setw(16) << avgRMSE << endl;
+
+            if (avgRMSE <= targetRMSE && numRFToTarget[q] < 0)
+                numRFToTarget[q] = numRFList.get(r).asInt();
+        }
+    }
+
+    cout << "-------------------------" << endl;
+    for (int q = 0 ; q < sequences.size() ; ++q)
+    {
+        cout << sequences.get(q).asString().c_str() << ": ";
+        if (numRFToTarget[q] > 0)
+            cout << numRFToTarget[q] << " projections reach the target RMSE" << endl;
+        else
+            cout << "target RMSE not reached" << endl;
+    }
+
+    return 0;
+}
@@ -45,76 +45,112 @@ A module that reads the projections from the configuration file RFmapper.ini and
 
 #include <cmath>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <yarp/os/Network.h>
 #include <yarp/os/RFModule.h>
 #include <yarp/os/Bottle.h>
 #include <yarp/os/BufferedPort.h>
 #include <yarp/os/Vocab.h>
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/os/Time.h>
 #include <yarp/sig/Vector.h>
 #include <yarp/sig/Matrix.h>
 #include <yarp/math/Math.h>
+#include <yarp/math/Rand.h>
 //#include <yarp/dev/Drivers.h>
 #include <yarp/conf/system.h>
 //#include <iCub/perception/models.h>
 
+#include "randomFeatures.h"
+#include "wireVector.h"
+#include "shmRing.h"
+#include "lockFree.h"
+
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::sig;
 using namespace yarp::math;
 
 /************************************************************************/
-// load_matrix function
-/************************************************************************/
-
-// load matrix from an ascii text file.
-void load_matrix(std::istream* is,
-        Matrix& matrix,
-        const std::string& delim = " ")
+// A worker thread which maps a fixed slice of the projection rows.
+// Each worker writes the sin/cos features of its own rows directly
+// into the shared output buffer, so no synchronization is needed
+// apart from the start/done handshake with the module thread.
+class mapperWorker : public Thread
 {
-    using namespace std;
+private:
+    const randomFeatures    *mapping;   // Mapping shared by all workers
+    const vector<Vector>    *batch; // Samples of the current batch
+    Matrix                  *F;     // [k x outDim] output features buffer
+    int                      r0;    // First projection row of the slice
+    int                      r1;    // One past the last projection row of the slice
+    int                      k;     // Number of samples in the current batch
+    int                      cpu;   // CPU the worker is pinned to (-1 for none)
+    Semaphore                startSem;
+    Semaphore                doneSem;
+
+    void run()
+    {
+        while (true)
+        {
+            startSem.wait();
+            if (isStopping())
+                break;
 
-    string      line;
-    string      strnum;
+            mapping->mapRows(*batch, k, *F, r0, r1);
 
-    long unsigned int rowidx =  0;
-    long int colidx =  -1;
-    
-    // parse line by line
-    while (getline(*is, line))
+            doneSem.post();
+        }
+    }
+
+public:
+    mapperWorker(const randomFeatures *m, const vector<Vector> *b, Matrix *out,
+                 int firstRow, int lastRow, int cpuId)
+        : mapping(m), batch(b), F(out), r0(firstRow), r1(lastRow), k(0), cpu(cpuId),
+          startSem(0), doneSem(0)
+    {
+    }
+
+    bool threadInit()
     {
-        for (string::const_iterator i = line.begin(); i != line.end(); i++)
+#ifdef __linux__
+        if (cpu >= 0)
         {
-            
-            // If i is not a delim, then append it to strnum
-            if (delim.find(*i) == string::npos)
-            {
-                strnum += *i;
-                if(i+1 != line.end())
-                {
-                    
-                    continue;
-                }
-            }
-            
-            // if strnum is still empty, it means the previous char is also a
-            // delim (several delims appear together). Ignore this char.
-            if (strnum.empty())
-                continue;
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(cpu, &cpuset);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0)
+                cout << "Warning: could not pin mapper worker to CPU " << cpu << endl;
+        }
+#endif
+        return true;
+    }
 
-            // If we reach here, we got a number. Convert it to double.
-            double number;
+    void onStop()
+    {
+        // Wake up the worker so that it can notice the stop request
+        startSem.post();
+    }
 
-            istringstream(strnum) >> number;
-            ++colidx;
-            matrix[rowidx][colidx] = number;
-            
-            strnum.clear();            
-        }        
-        ++rowidx;
-        colidx = -1;
+    // Start mapping the first n samples of the batch
+    void process(int n)
+    {
+        k = n;
+        startSem.post();
     }
-}
 
+    // Wait for the current batch to be mapped
+    void wait()
+    {
+        doneSem.wait();
+    }
+};
 
 
 /************************************************************************/
@@ -123,23 +159,134 @@ class RFmapper: public RFModule
 protected:
     
     // Ports
-    BufferedPort<Bottle>      outFeatures;
-    BufferedPort<Bottle>      inFeatures;
+    BufferedPort<wireVector>  outFeatures;
+    BufferedPort<wireVector>  inFeatures;
     Port                      rpcPort;
+    shmRingChannel            shmIn;    // Shared memory input from a co-located Normalizer
+    shmRingChannel            shmOut;   // Shared memory output to a co-located RRLSestimator
     
     // Data
     int d;
     int t;
     int numRF;
     string projFName;   // File name of the projections matrix
-    Matrix projMat;    // Pointer to the [numRF x d]-dimensional list of projections
+    randomFeatures mapping;     // [numRF x d]-dimensional list of projections and mapping type
     int mappingType;
-    Vector xin;
-    Bottle vout;
+    int maxBatch;       // Maximum number of queued samples mapped in a single cycle
+    int verbose;
+    vector<Vector> batch;   // Samples drained from the input port in the current cycle
+    Vector shmSample;       // Sample read from the shared memory ring
+    Matrix X;          // [d x k] stacked input features of the current batch
+    Matrix WX;         // [numRF x k] projected features of the current batch
+    Matrix F;          // [maxBatch x outDim] mapped features of the current batch
+    int numThreads;     // Number of mapper worker threads (1 maps in the module thread)
+    vector<mapperWorker*> workers;
+    vector<int> cpus;   // CPUs the workers are pinned to
+    Mutex mappingMutex; // Protects the mapping while features are grown from the rpc thread
+    long unsigned int mappedCount;  // Number of mapped samples
+    double mapTime;                 // Total time spent mapping samples [s]
     
+    /************************************************************************/
+    // Split the projection rows across numThreads worker threads
+    bool startWorkers()
+    {
+        if (numThreads <= 1)
+            return true;
+
+        for (int w = 0 ; w < numThreads ; ++w)
+        {
+            int firstRow = (w * numRF) / numThreads;
+            int lastRow = ((w + 1) * numRF) / numThreads;
+            int cpu = cpus.size() > 0 ? cpus[w % cpus.size()] : -1;
+
+            workers.push_back(new mapperWorker(&mapping, &batch, &F, firstRow, lastRow, cpu));
+            if (!workers.back()->start())
+            {
+                printf("Error: Could not start mapper worker %d!\n", w);
+                return false;
+            }
+        }
+        cout << "Mapping with " << numThreads << " worker threads" << endl;
+        return true;
+    }
+
+    /************************************************************************/
+    void stopWorkers()
+    {
+        for (size_t w = 0 ; w < workers.size() ; ++w)
+        {
+            workers[w]->stop();
+            delete workers[w];
+        }
+        workers.clear();
+    }
+
+    /************************************************************************/
+    // Features of a single input vector, as emitted on features:o.
+    // f is the mapSample() buffer, which holds outDim() values.
+    void mapInput(const double *x, vector<double> &f, vector<double> &out)
+    {
+        f.resize(mapping.outDim());
+        out.resize(mapping.outDim());
+        mapping.mapSample(x, &f[0]);
+        mapping.addFeatures(&f[0], &out[0]);
+    }
+
+    /************************************************************************/
+    // Check that mapInput() (map rpc) returns the features of the streaming
+    // path (mapRows()) on a fixed probe input
+    bool checkMapping()
+    {
+        vector<Vector> probe(1, Vector(d));
+        for (int i = 0 ; i < d ; ++i)
+            probe[0][i] = 0.5 * cos(1.0 + i);
+
+        Matrix Fs(1, mapping.outDim());
+        mapping.mapRows(probe, 1, Fs, 0, numRF);
+        vector<double> streamed(mapping.outDim());
+        mapping.addFeatures(Fs[0], &streamed[0]);
+
+        vector<double> f, out;
+        mapInput(probe[0].data(), f, out);
+
+        for (size_t i = 0 ; i < out.size() ; ++i)
+        {
+            if (fabs(out[i] - streamed[i]) > 1e-9)
+            {
+                printf("Error: map rpc feature %d differs from the streamed one (%g vs %g)!\n",
+                       (int)i, out[i], streamed[i]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /************************************************************************/
+    // Append n projections to the mapping. The new features are emitted
+    // after the current ones, so that the downstream estimator can grow
+    // its model as soon as it receives the first wider sample.
+    bool growFeatures(int n)
+    {
+        mappingMutex.lock();
+
+        stopWorkers();
+        bool ok = mapping.grow(n);
+        if (ok)
+        {
+            numRF = mapping.numRF;
+            F.resize(maxBatch, mapping.outDim());
+            cout << "Features grown to numRF = " << numRF << ", output features: " << mapping.outDim() << endl;
+            ok = checkMapping();
+        }
+        ok = startWorkers() && ok;
+
+        mappingMutex.unlock();
+        return ok;
+    }
+
 public:
     /************************************************************************/
-    RFmapper()
+    RFmapper() : mappedCount(0), mapTime(0.0)
     {
     }
 
@@ -158,8 +305,60 @@ public:
             reply.addVocab(Vocab::encode("many"));
             reply.addString("Available commands are:");
             reply.addString("help");
+            reply.addString("stats");
+            reply.addString("grow <n>");
+            reply.addString("map (inputs) ...");
             reply.addString("quit");
         }
+        else if (receivedCmd == "grow")
+        {
+            int n = command.get(1).asInt();
+            if (n <= 0)
+                reply.addString("Invalid number of projections.");
+            else if (growFeatures(n))
+            {
+                reply.addString("numRF");
+                reply.addInt(numRF);
+            }
+            else
+                reply.addString("Features growth failed.");
+        }
+        else if (receivedCmd == "map")
+        {
+            // Features of each list of d inputs, without updating any state
+            // (e.g. candidate configurations of the RandMotion exploration)
+            mappingMutex.lock();
+            vector<double> x(d), f, out;
+            for (int j = 1 ; j < command.size() ; ++j)
+            {
+                Bottle *inputs = command.get(j).asList();
+                if (inputs == 0 || inputs->size() != d)
+                {
+                    reply.clear();
+                    reply.addString("Invalid input vectors.");
+                    break;
+                }
+                for (int i = 0 ; i < d ; ++i)
+                    x[i] = inputs->get(i).asDouble();
+                mapInput(&x[0], f, out);
+
+                Bottle &featB = reply.addList();
+                for (size_t i = 0 ; i < out.size() ; ++i)
+                    featB.addDouble(out[i]);
+            }
+            mappingMutex.unlock();
+        }
+        else if (receivedCmd == "stats")
+        {
+            // Counters updated by updateModule, read atomically
+            long unsigned int n = atomicGet(mappedCount);
+            double time = atomicGet(mapTime);
+            reply.addString("samples");
+            reply.addInt((int)n);
+            reply.addString("avgMapTime");
+            reply.addDouble(n > 0 ? time / n : 0.0);
+            getWireStats().report(reply);
+        }
         else if (receivedCmd == "quit")
         {
             reply.addString("Quitting.");
@@ -187,39 +386,67 @@ public:
             return false;
         }
 
-        projMat.resize(numRF,d);      // Initialize projections matrix
+        mapping.numRF = numRF;
+        mapping.d = d;
+        
+        // Set up projections and mapping type
+        if (!mapping.configure(rf.findGroup("general"), rf.getContextPath() + "/proj/"))
+            return false;
+        mappingType = mapping.mappingType;
+        if (!checkMapping())
+            return false;
         
-        // Load precomputed projections from the specified file
-        string projFName = rf.findGroup("general").find("proj").toString();
-        if (projFName=="")
+        // Set verbosity
+        verbose = rf.findGroup("general").check("verbose",Value(0)).asInt();
+
+        // Set maximum number of samples mapped together
+        maxBatch = rf.findGroup("general").check("maxBatch",Value(64)).asInt();
+        if (maxBatch <= 0)
         {
-            cout<<"Sorry no projections were found, check config parameters"<<endl;
-            return -1;
+            cout << "Warning: maxBatch must be positive, setting maxBatch = 1" << endl;
+            maxBatch = 1;
         }
-        projFName = rf.getContextPath() + "/proj/" + projFName;
-        cout << "Using projections file: " << projFName.c_str() << endl;
 
-        ifstream* ifs = new ifstream;   //WARNING: Deallocate!
+        batch.resize(maxBatch);
+        for (int j = 0 ; j < maxBatch ; ++j)
+            batch[j].resize(d + t);
+        F.resize(maxBatch, mapping.outDim());
 
-        cout << "Trying to open ifstream..." << endl;        
-        ifs->open(projFName.c_str(), std::ifstream::in);
-        cout << "ifstream opened..." << endl;
-        load_matrix(ifs, projMat, " ");
-        cout << "Projections matrix loaded. Size: " << projMat.rows() << " x " << projMat.cols() << endl;
-        
-        if (projMat.rows() != numRF || projMat.cols() != d )
-        {
-            printf("Error: Inconsistent dimensionalities!\n");
+        // Set up the mapper worker threads
+        numThreads = rf.findGroup("general").check("numThreads",Value(1)).asInt();
+        if (numThreads > numRF)
+            numThreads = numRF;
+        if (numThreads < 1)
+            numThreads = 1;
+
+        // Optional list of CPUs the workers are pinned to, assigned round-robin
+        Bottle cpuList = rf.findGroup("general").findGroup("cpuAffinity").tail();
+        for (int i = 0 ; i < cpuList.size() ; ++i)
+            cpus.push_back(cpuList.get(i).asInt());
+
+        if (!startWorkers())
             return false;
+
+        // Optional shared memory input and output, replacing the ports
+        // between stages running on the same host
+        if (rf.findGroup("general").check("shmInput"))
+        {
+            string ring = rf.findGroup("general").find("shmInput").asString().c_str();
+            int slots = rf.findGroup("general").check("shmSlots",Value(256)).asInt();
+            if (!shmIn.openConsumer(ring, slots, d + t))
+                return false;
+        }
+        if (rf.findGroup("general").check("shmOutput"))
+        {
+            string ring = rf.findGroup("general").find("shmOutput").asString().c_str();
+            if (!shmOut.openProducer(ring, rf.findGroup("general").check("shmTimeout",Value(1.0)).asDouble()))
+                return false;
+            cout << "Writing features to shared memory ring " << ring << endl;
         }
-        
-        // Set mapping type
-        mappingType = rf.findGroup("general").check("mappingType",Value(1)).asInt();
-    
-        xin.resize(d);
 
         // Open ports
         string fwslash="/";
+        inFeatures.setStrict();     // Queue incoming samples instead of dropping them
         inFeatures.open((fwslash+name+"/features:i").c_str());
         printf("inFeatures opened\n");
         outFeatures.open((fwslash+name+"/features:o").c_str());
@@ -236,6 +463,12 @@ public:
     /************************************************************************/
     bool close()
     {        
+        // Stop worker threads
+        stopWorkers();
+
+        shmIn.close();
+        shmOut.close();
+
         // Close ports
         inFeatures.close();
         printf("inFeatures port closed\n");
@@ -263,67 +496,137 @@ public:
     bool updateModule()
     {
         
-        // Wait for incoming sample
-        Bottle *vin = inFeatures.read();    // blocking call
-        
-        if (vin == 0)
+        int k = 0;
+        if (shmIn.isActive())
+        {
+            // Wait for incoming sample
+            if (!shmIn.read(shmSample))     // blocking call
+            {
+                printf("Error: Read failed!\n");
+                return false;
+            }
+
+            // Drain the samples queued in the ring, preserving their order
+            do
+            {
+                if ((int)shmSample.size() >= d + t)
+                {
+                    std::copy(shmSample.data(), shmSample.data() + d + t, batch[k].data());
+                    ++k;
+                }
+                else
+                    printf("Error: Received %d elements, %d expected!\n", (int)shmSample.size(), d + t);
+            }
+            while (k < maxBatch && shmIn.read(shmSample, false));
+        }
+        else
         {
-            printf("Error: Read failed!\n");
-            return false;            
+            // Wait for incoming sample
+            wireVector *vin = inFeatures.read();    // blocking call
+
+            if (vin == 0)
+            {
+                printf("Error: Read failed!\n");
+                return false;
+            }
+
+            // Drain the samples queued on the input port, preserving their order
+            while (vin != 0)
+            {
+                if (vin->size() >= d + t)
+                {
+                    std::copy(vin->data.data(), vin->data.data() + d + t, batch[k].data());
+                    ++k;
+                }
+                else
+                    printf("Error: Received %d elements, %d expected!\n", vin->size(), d + t);
+
+                if (k == maxBatch || inFeatures.getPendingReads() <= 0)
+                    break;
+                vin = inFeatures.read(false);
+            }
         }
 
-        for (int i=0 ; i<d ; ++i)
-            xin[i] = vin->get(i).asDouble();    //WARNING: check!
+        if (k == 0)
+            return true;
+
+        if (verbose) cout << "Mapping " << k << " queued samples" << endl;
+
+        // Protect ON
+        mappingMutex.lock();
 
         // Apply random projections to incoming features
-        if (mappingType == 1)
+        if (mappingType == 1 || mappingType == 2)
         {
-            Vector wx(numRF);
-            
-            wx = projMat * xin;
-            
-            cout << "projMat = " << endl << projMat.toString() << endl;
-            cout << "xin = " << xin.toString() << endl;
-            cout << "wx = " << wx.toString() << endl;
-            
-            Vector sinwx(numRF);
-            Vector coswx(numRF);
-            
-            for ( int i = 0 ; i < numRF ; ++i )
+            double t0 = Time::now();
+
+            if (numThreads > 1)
             {
-                sinwx[i] = sin(wx[i]);
-                coswx[i] = cos(wx[i]);
+                // Each worker maps its own slice of the projection rows
+                for (size_t w = 0 ; w < workers.size() ; ++w)
+                    workers[w]->process(k);
+                for (size_t w = 0 ; w < workers.size() ; ++w)
+                    workers[w]->wait();
             }
-            
-            cout << "sinwx = " << sinwx.toString() << endl;
-            cout << "coswx = " << coswx.toString() << endl;
-            
-            // Send output features
-            Bottle &xout = outFeatures.prepare();
-            xout.clear(); //important, objects get recycled
-            
-            for( int i = 0 ; i < 2*numRF + t ; ++i )
+            else if (mapping.sparse)
             {
-                if (i < 2*numRF)      // Add mapped features
+                // Sparse-dense products, cost proportional to the nonzeros
+                mapping.mapRows(batch, k, F, 0, numRF);
+            }
+            else
+            {
+                // Stack the batch column-wise
+                if (X.cols() != k)
+                    X.resize(d,k);
+                for (int j = 0 ; j < k ; ++j)
+                    for (int i = 0 ; i < d ; ++i)
+                        X(i,j) = batch[j][i];
+
+                // Project the whole batch with a single matrix-matrix product
+                WX = mapping.W * X;
+
+                for (int j = 0 ; j < k ; ++j)
                 {
-                    if(i < numRF)
-                        xout.addDouble(sinwx[i]);
-                    else
-                        xout.addDouble(coswx[i-numRF]);
+                    double *f = F[j];
+                    for (int i = 0 ; i < numRF ; ++i)
+                        f[i] = WX(i,j);
+                    mapping.activate(f, 0, numRF);
                 }
-                else                  // Add labels
-                    xout.add(vin->get( i - 2*numRF + d ).asDouble());
             }
-            outFeatures.write();
+
+            atomicSet(mapTime, mapTime + Time::now() - t0);
+            atomicSet(mappedCount, mappedCount + k);
             
-            // Debug
-            cout << "Mapping sent:" << endl << xout.toString() << endl;
+            // Send output features, one message per sample in arrival order
+            int outDim = mapping.outDim();
+            for (int j = 0 ; j < k ; ++j)
+            {
+                wireVector &xout = outFeatures.prepare();
+                xout.data.resize(outDim + t); //objects get recycled
+                
+                mapping.addFeatures(F[j], xout.data.data());      // Add mapped features
+                for (int i = 0 ; i < t ; ++i)         // Add labels
+                    xout.data[outDim + i] = batch[j][d + i];
+
+                if (shmOut.isActive())
+                    shmOut.write(xout.data.data(), outDim + t);
+
+                // Wait for the previous sample to be sent, so that none is dropped
+                outFeatures.write(true);
+                
+                // Debug
+                if (verbose) cout << "Mapping sent:" << endl << xout.data.toString().c_str() << endl;
+            }
         }
         else
         {
+            mappingMutex.unlock();
             printf("Error: Mapping type not available!\n");
             return false;  
         }
+
+        mappingMutex.unlock();
+        // Protect OFF
         return true;
     }
 
@@ -336,6 +639,8 @@ public:
         // Interrupt any blocking reads on the output port
         outFeatures.interrupt();
         printf("outFeatures port interrupted\n");
+        shmIn.interrupt();
+        shmOut.interrupt();
 
         // Interrupt any blocking reads on the rpc port        
         rpcPort.interrupt();
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _FAST_TRIG
+#define _FAST_TRIG
+
+#include <cmath>
+
+/** Fast approximation of sin and cos for the random features mapping.
+ *
+ * The argument is reduced to \f$ r = x - k \pi/2 \in [-\pi/4, \pi/4] \f$
+ * (Cody-Waite reduction with a two-part \f$ \pi/2 \f$), then \f$ \sin r \f$ and
+ * \f$ \cos r \f$ are evaluated with degree 7 and degree 6 minimax polynomials
+ * and the results are swapped and negated according to the quadrant \f$ k \bmod 4 \f$.
+ *
+ * The maximum absolute error with respect to libm is \f$ 3.3 \cdot 10^{-8} \f$
+ * for both sin and cos and \f$ |x| < 10^5 \f$ (the polynomials alone are within
+ * \f$ 1.8 \cdot 10^{-9} \f$ and \f$ 3.3 \cdot 10^{-8} \f$ on the reduced interval).
+ *
+ * Accuracy degrades for larger arguments, which never occur when projecting
+ * inputs normalized in [0, 1]. The loops are written so that gcc vectorizes
+ * them (checked with -fopt-info-vec, see CMakeLists.txt): the rounding to the
+ * nearest integer adds and subtracts 1.5 2^52 instead of calling floor(), the
+ * quadrant is computed and selected in double precision, and the outputs are
+ * restrict pointers. The rounding trick requires the default floating point
+ * semantics: do not build with -ffast-math.
+ */
+
+static const double FAST_TRIG_MAX_ERROR = 3.3e-8;   ///< Documented maximum absolute error
+
+static const double FAST_TRIG_2_PI   = 6.36619772367581382433e-01;  ///< 2/pi
+static const double FAST_TRIG_PIO2_1 = 1.57079632673412561417e+00;  ///< First 33 bits of pi/2
+static const double FAST_TRIG_PIO2_T = 6.07710050650619224932e-11;  ///< pi/2 - FAST_TRIG_PIO2_1
+static const double FAST_TRIG_ROUND  = 6755399441055744.0;          ///< 1.5 2^52, rounds to integer when added
+
+// Minimax coefficients of sin(r) = r + r^3 (S1 + S2 r^2 + S3 r^4) on [-pi/4, pi/4]
+static const double FAST_TRIG_S1 = -1.66666506692941472788e-01;
+static const double FAST_TRIG_S2 =  8.33197866315608960291e-03;
+static const double FAST_TRIG_S3 = -1.94956362375740144474e-04;
+
+// Minimax coefficients of cos(r) = 1 + r^2 (C1 + C2 r^2 + C3 r^4) on [-pi/4, pi/4]
+static const double FAST_TRIG_C1 = -4.99998947813705765835e-01;
+static const double FAST_TRIG_C2 =  4.16562945784470084674e-02;
+static const double FAST_TRIG_C3 = -1.35978231113433990699e-03;
+
+/** Computes the sin and cos of n values.
+ * @param xs Input values, replaced by their sines.
+ * @param c Output cosines (must not overlap xs).
+ * @param n Number of values. */
+inline void fastSinCos(double * __restrict xs, double * __restrict c, int n)
+{
+    for (int i = 0 ; i < n ; ++i)
+    {
+        double x = xs[i];
+        double k = (x * FAST_TRIG_2_PI + FAST_TRIG_ROUND) - FAST_TRIG_ROUND;
+        double r = (x - k * FAST_TRIG_PIO2_1) - k * FAST_TRIG_PIO2_T;
+        double z = r * r;
+
+        double sr = r + r * z * (FAST_TRIG_S1 + z * (FAST_TRIG_S2 + z * FAST_TRIG_S3));
+        double cr = 1.0 + z * (FAST_TRIG_C1 + z * (FAST_TRIG_C2 + z * FAST_TRIG_C3));
+
+        // Quadrant k mod 4 in [0, 3]: k/4 - 3/8 rounds to floor(k/4)
+        double q = k - 4.0 * ((k * 0.25 - 0.375 + FAST_TRIG_ROUND) - FAST_TRIG_ROUND);
+        bool odd = fabs(q - 2.0) == 1.0;
+        double sinv = odd ? cr : sr;
+        double cosv = odd ? sr : cr;
+        double sinSign = q >= 2.0 ? -1.0 : 1.0;
+        double cosSign = fabs(q - 1.5) < 1.0 ? -1.0 : 1.0;
+
+        xs[i] = sinSign * sinv;
+        c[i] = cosSign * cosv;
+    }
+}
+
+/** Computes the cos of n values, with the same error bound as fastSinCos().
+ * @param xc Input values, replaced by their cosines.
+ * @param n Number of values. */
+inline void fastCos(double * __restrict xc, int n)
+{
+    for (int i = 0 ; i < n ; ++i)
+    {
+        double x = xc[i];
+        double k = (x * FAST_TRIG_2_PI + FAST_TRIG_ROUND) - FAST_TRIG_ROUND;
+        double r = (x - k * FAST_TRIG_PIO2_1) - k * FAST_TRIG_PIO2_T;
+        double z = r * r;
+
+        double sr = r + r * z * (FAST_TRIG_S1 + z * (FAST_TRIG_S2 + z * FAST_TRIG_S3));
+        double cr = 1.0 + z * (FAST_TRIG_C1 + z * (FAST_TRIG_C2 + z * FAST_TRIG_C3));
+
+        // Odd quadrants blended arithmetically: a select between the two
+        // polynomials is turned into a branch, which blocks vectorization
+        double q = k - 4.0 * ((k * 0.25 - 0.375 + FAST_TRIG_ROUND) - FAST_TRIG_ROUND);
+        double odd = fabs(q - 2.0) == 1.0 ? 1.0 : 0.0;
+        double cosSign = fabs(q - 1.5) < 1.0 ? -1.0 : 1.0;
+
+        xc[i] = cosSign * (cr + odd * (sr - cr));
+    }
+}
+
+#endif
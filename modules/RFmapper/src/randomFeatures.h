@@ -0,0 +1,687 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _RANDOM_FEATURES
+#define _RANDOM_FEATURES
+
+#include <iostream>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdio>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Value.h>
+#include <yarp/sig/Vector.h>
+#include <yarp/sig/Matrix.h>
+#include <yarp/math/Rand.h>
+
+#include "fastTrig.h"
+
+/************************************************************************/
+// load_matrix function
+/************************************************************************/
+
+// load matrix from an ascii text file.
+inline void load_matrix(std::istream* is,
+        yarp::sig::Matrix& matrix,
+        const std::string& delim = " ")
+{
+    using namespace std;
+
+    string      line;
+    string      strnum;
+
+    long unsigned int rowidx =  0;
+    long int colidx =  -1;
+    
+    // parse line by line
+    while (getline(*is, line))
+    {
+        for (string::const_iterator i = line.begin(); i != line.end(); i++)
+        {
+            
+            // If i is not a delim, then append it to strnum
+            if (delim.find(*i) == string::npos)
+            {
+                strnum += *i;
+                if(i+1 != line.end())
+                {
+                    
+                    continue;
+                }
+            }
+            
+            // if strnum is still empty, it means the previous char is also a
+            // delim (several delims appear together). Ignore this char.
+            if (strnum.empty())
+                continue;
+
+            // If we reach here, we got a number. Convert it to double.
+            double number;
+
+            istringstream(strnum) >> number;
+            ++colidx;
+            matrix[rowidx][colidx] = number;
+            
+            strnum.clear();            
+        }        
+        ++rowidx;
+        colidx = -1;
+    }
+}
+
+
+
+/************************************************************************/
+// Inverse of the standard normal CDF (Acklam's rational approximation,
+// relative error below 1.15e-9)
+inline double invNormalCdf(double p)
+{
+    static const double a[6] = { -3.969683028665376e+01,  2.209460984245205e+02,
+                                 -2.759285104469687e+02,  1.383577518672690e+02,
+                                 -3.066479806614716e+01,  2.506628277459239e+00 };
+    static const double b[5] = { -5.447609879822406e+01,  1.615858368580409e+02,
+                                 -1.556989798598866e+02,  6.680131188771972e+01,
+                                 -1.328068155288572e+01 };
+    static const double c[6] = { -7.784894002430293e-03, -3.223964580411365e-01,
+                                 -2.400758277161838e+00, -2.549732539343734e+00,
+                                  4.374664141464968e+00,  2.938163982698783e+00 };
+    static const double d[4] = {  7.784695709041462e-03,  3.224671290700398e-01,
+                                  2.445134137142996e+00,  3.754408661907416e+00 };
+    const double pLow = 0.02425;
+
+    if (p < pLow)
+    {
+        double q = sqrt(-2.0 * log(p));
+        return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+               ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    if (p > 1.0 - pLow)
+    {
+        double q = sqrt(-2.0 * log(1.0 - p));
+        return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+                ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+           (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+}
+
+/************************************************************************/
+// Halton low-discrepancy sequence in [0, 1)^dim, scrambled with a random
+// permutation of the nonzero digits of each base (Faure and Lemieux, 2009)
+// to break the correlations between the coordinates of large prime bases.
+class scrambledHalton
+{
+private:
+    std::vector<int>               bases;  // First dim primes
+    std::vector<std::vector<int> > perms;  // Digit permutations, perm[0] = 0
+
+public:
+    scrambledHalton(int dim, int seed)
+    {
+        for (int n = 2 ; (int)bases.size() < dim ; ++n)
+        {
+            bool isPrime = true;
+            for (size_t k = 0 ; k < bases.size() && bases[k] * bases[k] <= n ; ++k)
+                if (n % bases[k] == 0)
+                    isPrime = false;
+            if (isPrime)
+                bases.push_back(n);
+        }
+
+        yarp::math::RandScalar rnd(seed);
+        perms.resize(dim);
+        for (int l = 0 ; l < dim ; ++l)
+        {
+            int base = bases[l];
+            perms[l].resize(base);
+            for (int k = 0 ; k < base ; ++k)
+                perms[l][k] = k;
+            // Fisher-Yates shuffle of the digits 1..base-1
+            for (int k = base - 1 ; k > 1 ; --k)
+            {
+                int j = 1 + (int)(rnd.get() * k);
+                if (j > k)
+                    j = k;
+                std::swap(perms[l][k], perms[l][j]);
+            }
+        }
+    }
+
+    // n-th point of the sequence
+    void point(long unsigned int n, yarp::sig::Vector &u) const
+    {
+        for (size_t l = 0 ; l < bases.size() ; ++l)
+        {
+            int base = bases[l];
+            double f = 1.0 / base;
+            double x = 0.0;
+            for (long unsigned int m = n ; m > 0 ; m /= base)
+            {
+                x += perms[l][m % base] * f;
+                f /= base;
+            }
+            u[l] = x;
+        }
+    }
+};
+
+
+/************************************************************************/
+// Random features mapping. The projections are stored either as a dense
+// [numRF x d] matrix or, for sparse random projections, in compressed
+// sparse row (CSR) form, so that the cost of a projection grows with the
+// number of nonzeros rather than with numRF*d.
+// Mapping types:
+//  1 - [ sin(Wx) , cos(Wx) ], 2*numRF features
+//  2 - sqrt(2) * cos(Wx + b), numRF features, b uniform in [0, 2*pi)
+// Projections appended online form a new block, whose features are
+// emitted after those of the previous blocks.
+class randomFeatures
+{
+public:
+    int     numRF;
+    int     d;
+    int     mappingType;
+    bool    sparse;
+    bool    fastTrig;       // Use the fast sin/cos approximation
+    bool    growable;       // Sampling parameters known for the projections appended online
+    yarp::sig::Matrix  W;              // Dense projections
+    yarp::sig::Vector  b;              // Phase offsets (mapping type 2)
+    std::vector<int>    rowPtr;  // CSR row offsets, numRF+1 entries
+    std::vector<int>    colIdx;  // CSR column index of each nonzero
+    std::vector<double> val;     // CSR value of each nonzero
+    std::vector<int>    blockStart;  // First projection row of each block
+
+    // Sampling parameters of generated projections
+    std::string  sequence;      // 'mc' (Monte Carlo) or 'halton' (quasi-Monte Carlo)
+    std::string  kernel;
+    double  sigma;
+    double  nu;
+    double  sparsity;
+    int     seed;
+
+    randomFeatures() : numRF(0), d(0), mappingType(1), sparse(false), fastTrig(false), growable(true),
+                       blockStart(1, 0), sequence("mc"), kernel("gaussian"), sigma(1.0), nu(1.5), sparsity(1.0), seed(0)
+    {
+    }
+
+    // Set up the mapping from the configuration group of RFmapper: sampling
+    // parameters, projections (generated, or loaded from the file 'proj' in
+    // projDir), mapping type and fast sin/cos. numRF and d must be set.
+    bool configure(const yarp::os::Searchable &cfg, const std::string &projDir)
+    {
+        // Set projections type: 'dense' or 'sparse'
+        std::string projType = cfg.check("projType",yarp::os::Value("dense")).asString().c_str();
+        std::string projFName = cfg.find("proj").toString().c_str();
+
+        // Set sampling parameters, also used for the projections appended online
+        seed = cfg.check("seed",yarp::os::Value(0)).asInt();
+        sigma = cfg.check("sigma",yarp::os::Value(1.0)).asDouble();
+        kernel = cfg.check("kernel",yarp::os::Value("gaussian")).asString().c_str();
+        sequence = cfg.check("sequence",yarp::os::Value("mc")).asString().c_str();
+        nu = cfg.check("nu",yarp::os::Value(1.5)).asDouble();
+        sparsity = cfg.check("sparsity",yarp::os::Value(sqrt((double)d))).asDouble();
+
+        if (sigma <= 0.0)
+        {
+            printf("Error: sigma must be positive!\n");
+            return false;
+        }
+        if (kernel != "gaussian" && kernel != "laplacian" && kernel != "matern")
+        {
+            printf("Error: Unknown kernel %s!\n", kernel.c_str());
+            return false;
+        }
+        if (sequence != "mc" && sequence != "halton")
+        {
+            printf("Error: Unknown sequence %s!\n", sequence.c_str());
+            return false;
+        }
+        if (kernel == "matern" && (nu <= 0.0 || fabs(2.0 * nu - floor(2.0 * nu + 0.5)) > 1e-9))
+        {
+            printf("Error: nu must be a positive multiple of 0.5!\n");
+            return false;
+        }
+        if (sparsity < 1.0)
+        {
+            printf("Error: sparsity must be >= 1!\n");
+            return false;
+        }
+        if (projType == "sparse" && (kernel != "gaussian" || sequence != "mc"))
+        {
+            // The sparse entries only match the moments of the gaussian
+            // kernel, and are drawn at random (also when grown)
+            printf("Error: sparse projections require kernel gaussian and sequence mc!\n");
+            return false;
+        }
+
+        if (projType == "sparse" && projFName == "")
+        {
+            // Generate sparse random projections from the given seed
+            generateSparse(0);
+            std::cout << "Sparse projections generated with s = " << sparsity << ", sigma = " << sigma << ", seed = " << seed << std::endl;
+        }
+        else if (projFName == "")
+        {
+            // Sample the projections from the spectral density of the kernel
+            generateDense(0);
+            std::cout << "Projections sampled (" << sequence << ") for the " << kernel << " kernel with sigma = " << sigma << ", seed = " << seed << std::endl;
+        }
+        else
+        {
+            W.resize(numRF,d);      // Initialize projections matrix
+
+            // Load precomputed projections from the specified file
+            projFName = projDir + projFName;
+            std::cout << "Using projections file: " << projFName.c_str() << std::endl;
+
+            std::ifstream ifs;
+
+            std::cout << "Trying to open ifstream..." << std::endl;
+            ifs.open(projFName.c_str(), std::ifstream::in);
+            std::cout << "ifstream opened..." << std::endl;
+            load_matrix(&ifs, W, " ");
+            std::cout << "Projections matrix loaded. Size: " << W.rows() << " x " << W.cols() << std::endl;
+
+            if (W.rows() != numRF || W.cols() != d )
+            {
+                printf("Error: Inconsistent dimensionalities!\n");
+                return false;
+            }
+
+            // The file does not record the kernel it was sampled for: the
+            // projections appended online are only drawn if it is given
+            growable = cfg.check("kernel") && cfg.check("sigma");
+            if (!growable)
+                std::cout << "kernel and sigma not given for the projections file: features growth disabled" << std::endl;
+            else if (kernel == "gaussian")
+            {
+                // The entries of Gaussian projections have standard deviation 1 / sigma
+                double fileScale = entryScale();
+                std::cout << "Projections file scale: " << fileScale << ", 1 / sigma = " << 1.0 / sigma << std::endl;
+                if (fabs(fileScale * sigma - 1.0) > 0.1)
+                    std::cout << "Warning: the projections file does not match the gaussian kernel with sigma = " << sigma
+                              << " (sigma = " << 1.0 / fileScale << " from the file): grown features would mix two kernels" << std::endl;
+            }
+
+            // Keep only the nonzero projection weights
+            if (projType == "sparse")
+                toSparse();
+        }
+
+        if (sparse)
+            std::cout << "Sparse projections: " << nnz() << " nonzeros out of " << numRF * d << std::endl;
+
+        // Set mapping type
+        mappingType = cfg.check("mappingType",yarp::os::Value(1)).asInt();
+        if (mappingType != 1 && mappingType != 2)
+        {
+            printf("Error: Mapping type not available!\n");
+            return false;
+        }
+        if (mappingType == 2)
+            generatePhases(0);
+        std::cout << "Output features: " << outDim() << std::endl;
+
+        // Set fast sin/cos approximation
+        fastTrig = cfg.check("fastTrig",yarp::os::Value(0)).asInt() != 0;
+        if (fastTrig)
+        {
+            // Check the approximation against libm over the range of the
+            // projections of inputs normalized in [0, 1]
+            double range = projectedRange();
+            double maxErr = 0.0;
+            const int numChecks = 100000;
+            for (int i = 0 ; i <= numChecks ; ++i)
+            {
+                double x = -range + 2.0 * range * i / numChecks;
+                double s = x, c;
+                fastSinCos(&s, &c, 1);
+                maxErr = std::max(maxErr, std::max(fabs(s - sin(x)), fabs(c - cos(x))));
+            }
+            std::cout << "Fast sin/cos enabled. Max error on [" << -range << ", " << range << "]: " << maxErr << std::endl;
+            if (maxErr > FAST_TRIG_MAX_ERROR)
+                std::cout << "Warning: fast sin/cos error exceeds the documented bound " << FAST_TRIG_MAX_ERROR << std::endl;
+        }
+
+        return true;
+    }
+
+    // Number of output features
+    int outDim() const
+    {
+        return mappingType == 2 ? numRF : 2 * numRF;
+    }
+
+    // Number of stored projection weights
+    int nnz() const
+    {
+        return sparse ? (int)val.size() : numRF * d;
+    }
+
+    // Draw dense projections [first, numRF) from the spectral density of a
+    // shift-invariant kernel of width sigma (Rahimi and Recht, 2007):
+    //  gaussian  - exp(-|x-y|^2 / (2 sigma^2)), w ~ N(0, I / sigma^2)
+    //  laplacian - exp(-|x-y|_1 / sigma), w_l ~ Cauchy(0, 1 / sigma)
+    //  matern    - Matern kernel of order nu (2*nu integer), w ~ multivariate
+    //              Student-t with 2*nu degrees of freedom, scaled by 1 / sigma
+    // The densities are sampled by inverting their CDFs at uniform points,
+    // drawn at random ('mc') or from the scrambled Halton sequence ('halton',
+    // Yang et al., 2014), which covers the spectrum more evenly and needs
+    // fewer features for the same kernel approximation error. Projection i
+    // is always the i-th point of the sequence, so grown blocks extend it.
+    bool generateDense(int first)
+    {
+        if (kernel != "gaussian" && kernel != "laplacian" && kernel != "matern")
+            return false;
+        if (sequence != "mc" && sequence != "halton")
+            return false;
+
+        // Matern needs 2*nu extra coordinates for the chi-square scaling
+        int dof = kernel == "matern" ? (int)floor(2.0 * nu + 0.5) : 0;
+        int dim = d + dof;
+
+        yarp::math::RandScalar rnd(seed + first);
+        scrambledHalton halton(dim, seed);
+        yarp::sig::Vector u(dim);
+
+        // Keep the rows drawn so far
+        yarp::sig::Matrix Wold = W;
+        W.resize(numRF, d);
+        for (int i = 0 ; i < first ; ++i)
+            for (int l = 0 ; l < d ; ++l)
+                W(i,l) = Wold(i,l);
+
+        for (int i = first ; i < numRF ; ++i)
+        {
+            if (sequence == "halton")
+                halton.point(i + 1, u);     // Skip the origin
+            else
+                for (int l = 0 ; l < dim ; ++l)
+                    u[l] = rnd.get();
+
+            // Keep away from the infinite tails
+            for (int l = 0 ; l < dim ; ++l)
+                u[l] = std::min(std::max(u[l], 1e-12), 1.0 - 1e-12);
+
+            if (kernel == "gaussian")
+            {
+                for (int l = 0 ; l < d ; ++l)
+                    W(i,l) = invNormalCdf(u[l]) / sigma;
+            }
+            else if (kernel == "laplacian")
+            {
+                for (int l = 0 ; l < d ; ++l)
+                    W(i,l) = tan(M_PI * (u[l] - 0.5)) / sigma;
+            }
+            else
+            {
+                // Chi-square with 2*nu degrees of freedom
+                double chi2 = 0.0;
+                for (int l = d ; l < dim ; ++l)
+                {
+                    double z = invNormalCdf(u[l]);
+                    chi2 += z * z;
+                }
+                double scale = sqrt(dof / chi2) / sigma;
+                for (int l = 0 ; l < d ; ++l)
+                    W(i,l) = invNormalCdf(u[l]) * scale;
+            }
+        }
+        sparse = false;
+        return true;
+    }
+
+    // Draw the phase offsets [first, numRF) of mapping type 2
+    void generatePhases(int first)
+    {
+        yarp::math::RandScalar rnd(seed + first + 2);
+
+        yarp::sig::Vector bold = b;
+        b.resize(numRF);
+        for (int i = 0 ; i < first ; ++i)
+            b[i] = bold[i];
+        for (int i = first ; i < numRF ; ++i)
+            b[i] = 2.0 * M_PI * rnd.get();
+    }
+
+    // Compress the dense projections into CSR form, dropping the zeros
+    void toSparse()
+    {
+        rowPtr.assign(numRF + 1, 0);
+        colIdx.clear();
+        val.clear();
+        for (int i = 0 ; i < numRF ; ++i)
+        {
+            for (int l = 0 ; l < d ; ++l)
+            {
+                if (W(i,l) != 0.0)
+                {
+                    colIdx.push_back(l);
+                    val.push_back(W(i,l));
+                }
+            }
+            rowPtr[i+1] = val.size();
+        }
+        W.resize(0,0);
+        sparse = true;
+    }
+
+    // Draw sparse random projections [first, numRF) (Achlioptas, 2003;
+    // Li et al., 2006). Each entry is sqrt(s)/sigma with probability 1/(2s),
+    // -sqrt(s)/sigma with probability 1/(2s) and 0 otherwise, i.e. zero mean
+    // and variance 1/sigma^2 as the Gaussian projections of the RBF kernel.
+    // s = 3 gives Achlioptas' projections, s = sqrt(d) the very sparse ones.
+    void generateSparse(int first)
+    {
+        yarp::math::RandScalar rnd(seed + first);
+        double v = sqrt(sparsity) / sigma;
+
+        rowPtr.resize(numRF + 1, 0);
+        for (int i = first ; i < numRF ; ++i)
+        {
+            for (int l = 0 ; l < d ; ++l)
+            {
+                double u = rnd.get();
+                if (u < 0.5 / sparsity)
+                {
+                    colIdx.push_back(l);
+                    val.push_back(v);
+                }
+                else if (u < 1.0 / sparsity)
+                {
+                    colIdx.push_back(l);
+                    val.push_back(-v);
+                }
+            }
+            rowPtr[i+1] = val.size();
+        }
+        sparse = true;
+    }
+
+    // Append n projections drawn with the current sampling parameters
+    // as a new block
+    bool grow(int n)
+    {
+        if (!growable)
+        {
+            printf("Error: Cannot grow projections loaded from file without kernel and sigma!\n");
+            return false;
+        }
+
+        int first = numRF;
+        numRF += n;
+
+        if (sparse)
+            generateSparse(first);
+        else if (!generateDense(first))
+        {
+            numRF = first;
+            return false;
+        }
+
+        if (mappingType == 2)
+            generatePhases(first);
+
+        blockStart.push_back(first);
+        return true;
+    }
+
+    // Write the outDim() features f of a sample to out, block by block.
+    // For mapping type 1, f holds all the sines followed by all the cosines,
+    // while each block is emitted as [ sin , cos ].
+    void addFeatures(const double *f, double *out) const
+    {
+        if (mappingType == 2)
+        {
+            std::copy(f, f + numRF, out);
+            return;
+        }
+
+        for (size_t blk = 0 ; blk < blockStart.size() ; ++blk)
+        {
+            int r0 = blockStart[blk];
+            int r1 = blk + 1 < blockStart.size() ? blockStart[blk+1] : numRF;
+            out = std::copy(f + r0, f + r1, out);
+            out = std::copy(f + numRF + r0, f + numRF + r1, out);
+        }
+    }
+
+    // Project x onto the i-th projection
+    inline double project(int i, const double *x) const
+    {
+        double wx = 0.0;
+        if (sparse)
+        {
+            for (int p = rowPtr[i] ; p < rowPtr[i+1] ; ++p)
+                wx += val[p] * x[colIdx[p]];
+        }
+        else
+        {
+            const double *w = W[i];
+            for (int l = 0 ; l < d ; ++l)
+                wx += w[l] * x[l];
+        }
+        return wx;
+    }
+
+    // Root mean square of the dense projection weights
+    double entryScale() const
+    {
+        double sum2 = 0.0;
+        for (int i = 0 ; i < (int)W.rows() ; ++i)
+            for (int l = 0 ; l < (int)W.cols() ; ++l)
+                sum2 += W(i,l) * W(i,l);
+        return W.rows() * W.cols() > 0 ? sqrt(sum2 / (W.rows() * W.cols())) : 0.0;
+    }
+
+    // Largest |w'x| over inputs normalized in [0, 1], i.e. the maximum
+    // L1 norm of the projections
+    double projectedRange() const
+    {
+        double range = 0.0;
+        for (int i = 0 ; i < numRF ; ++i)
+        {
+            double rowNorm = 0.0;
+            if (sparse)
+            {
+                for (int p = rowPtr[i] ; p < rowPtr[i+1] ; ++p)
+                    rowNorm += fabs(val[p]);
+            }
+            else
+            {
+                for (int l = 0 ; l < d ; ++l)
+                    rowNorm += fabs(W(i,l));
+            }
+            if (rowNorm > range)
+                range = rowNorm;
+        }
+        return range;
+    }
+
+    // Replace the projected values stored in f[r0, r1) with the features.
+    // Mapping type 1 writes the sines in place and the corresponding cosines
+    // in f[numRF + r0, numRF + r1), mapping type 2 writes sqrt(2)*cos(wx + b)
+    // in place
+    inline void activate(double *f, int r0, int r1) const
+    {
+        if (mappingType == 2)
+        {
+            for (int i = r0 ; i < r1 ; ++i)
+                f[i] += b[i];
+
+            if (fastTrig)
+                fastCos(f + r0, r1 - r0);
+            else
+            {
+                for (int i = r0 ; i < r1 ; ++i)
+                    f[i] = cos(f[i]);
+            }
+
+            for (int i = r0 ; i < r1 ; ++i)
+                f[i] *= M_SQRT2;
+        }
+        else if (fastTrig)
+            fastSinCos(f + r0, f + numRF + r0, r1 - r0);
+        else
+        {
+            for (int i = r0 ; i < r1 ; ++i)
+            {
+                double wx = f[i];
+                f[i] = sin(wx);
+                f[numRF + i] = cos(wx);
+            }
+        }
+    }
+
+    // Map a single sample x into f (outDim() values). With a single block
+    // the features are in the same order as emitted by addFeatures()
+    void mapSample(const double *x, double *f) const
+    {
+        for (int i = 0 ; i < numRF ; ++i)
+            f[i] = project(i, x);
+        activate(f, 0, numRF);
+    }
+
+    // Map the first k samples of the batch on projection rows [r0, r1),
+    // writing the features into the rows of F
+    void mapRows(const std::vector<yarp::sig::Vector> &batch, int k, yarp::sig::Matrix &F, int r0, int r1) const
+    {
+        for (int j = 0 ; j < k ; ++j)
+        {
+            const double *x = batch[j].data();
+            double *f = F[j];
+
+            for (int i = r0 ; i < r1 ; ++i)
+                f[i] = project(i, x);
+            activate(f, r0, r1);
+        }
+    }
+};
+
+#endif
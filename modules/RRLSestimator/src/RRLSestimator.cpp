@@ -22,17 +22,19 @@
 #include <sstream>
 #include <iomanip>
 #include <string>
+#include <vector>
 #include <yarp/os/Time.h>
 
-#include "gurls++/recrlswrapperchol.h"
-#include "gurls++/rlsprimal.h"
-#include "gurls++/primal.h"
+#include "rrlsLearner.h"
+#include "wireVector.h"
+#include "shmRing.h"
 
 #include <yarp/os/Network.h>
 #include <yarp/os/RFModule.h>
 #include <yarp/os/Bottle.h>
 #include <yarp/os/BufferedPort.h>
 #include <yarp/os/Vocab.h>
+#include <yarp/os/Mutex.h>
 #include <yarp/math/Math.h>
 #include <yarp/conf/system.h>
 
@@ -50,10 +52,12 @@ class RRLSestimator: public RFModule
 protected:
     
     // Ports
-    BufferedPort<Bottle>      inVec;
+    BufferedPort<wireVector>  inVec;
     BufferedPort<Bottle>      pred;
     BufferedPort<Bottle>      perf;
     Port                      rpcPort;
+    shmRingChannel            shmIn;    // Shared memory input from a co-located RFmapper
+    Vector                    shmSample;
     
     // Data
     bool verbose;
@@ -72,15 +76,26 @@ protected:
     gMat2D<T> trainSet;    
     gMat2D<T> Xtr;    
     gMat2D<T> ytr;    
-    RecursiveRLSCholUpdateWrapper<T> estimator;
-    gMat2D<T> varCols;          // Matrix containing the column-wise variances computed on the training set
+    rrlsLearner learner;        // Recursive RLS model and performance measure
+    Mutex learnerMutex;         // Protects the model from the 'variance' rpc command
     
-    gMat2D<T> error;
     gMat2D<T> storedError;      // Contains the first numErr computed errors
 
+    /************************************************************************/
+    // Read the next sample from the shared memory ring, if configured, or
+    // from the input port. Returns 0 if the read was interrupted.
+    const Vector *readSample()
+    {
+        if (shmIn.isActive())
+            return shmIn.read(shmSample) ? &shmSample : 0;
+
+        wireVector *bin = inVec.read();    // blocking call
+        return bin != 0 ? &bin->data : 0;
+    }
+
 public:
     /************************************************************************/
-    RRLSestimator() : estimator("recursiveRLSChol"), updateCount(0)
+    RRLSestimator() : updateCount(0)
     {
     }
 
@@ -99,8 +114,51 @@ public:
             reply.addVocab(Vocab::encode("many"));
             reply.addString("Available commands are:");
             reply.addString("help");
+            reply.addString("stats");
+            reply.addString("variance (features) ...");
             reply.addString("quit");
         }
+        else if (receivedCmd == "stats")
+        {
+            reply.addString("samples");
+            reply.addInt(updateCount);
+            getWireStats().report(reply);
+        }
+        else if (receivedCmd == "variance")
+        {
+            // Predictive variance of each list of d features, e.g. mapped by
+            // RFmapper 'map' at candidate configurations (RandMotion exploration)
+            Bottle &varB = reply.addList();
+            vector<double> phi;
+            learnerMutex.lock();
+            for (int j = 1 ; j < command.size() ; ++j)
+            {
+                Bottle *features = command.get(j).asList();
+                if (features == 0 || features->size() != d)
+                {
+                    varB.clear();
+                    break;
+                }
+                phi.resize(d);
+                for (int i = 0 ; i < d ; ++i)
+                    phi[i] = features->get(i).asDouble();
+                double v = 0.0;
+                if (!learner.variance(&phi[0], v))
+                {
+                    varB.clear();
+                    break;
+                }
+                varB.addDouble(v);
+            }
+            learnerMutex.unlock();
+
+            // Empty list on failure, with the reason
+            if (varB.size() != command.size() - 1)
+            {
+                reply.clear();
+                reply.addString("Model not trained yet or invalid feature vectors.");
+            }
+        }
         else if (receivedCmd == "quit")
         {
             reply.addString("Quitting.");
@@ -130,6 +188,9 @@ public:
             return false;
         }
         
+        // Set regularization of the features added online
+        learner.growLambda = rf.check("growLambda",Value(1.0)).asDouble();
+        
         // Set perf type
         perfType = rf.check("perf",Value("RMSE")).asString();
         
@@ -203,12 +264,24 @@ public:
         // Attach rpcPort to the respond() method
         attach(rpcPort);
 
+        // Optional shared memory input, replacing vec:i when RFmapper runs on the same host.
+        // Slots must fit the widest sample, including the features grown online.
+        if (rf.check("shmInput"))
+        {
+            string ring = rf.find("shmInput").asString().c_str();
+            int slots = rf.check("shmSlots",Value(256)).asInt();
+            int slotSize = rf.check("shmSlotSize",Value(d + t)).asInt();
+            if (!shmIn.openConsumer(ring, slots, slotSize > d + t ? slotSize : d + t))
+                return false;
+        }
+
         // Initialize random number generator
         srand(static_cast<unsigned int>(time(NULL)));
 
-        // Initialize error structures
-        error.resize(1,t);
-        error = gMat2D<T>::zeros(1, t);          //
+        // Initialize sample and error structures
+        learner.verbose = verbose;
+        learner.perfType = perfType;
+        learner.init(d, t);
         
         if (savedPerfNum > 0)
         {
@@ -280,25 +353,8 @@ public:
                     }
                     cout << "ytr initialized!" << endl;
 
-                    // Compute variance for each output on the training set
-                    gMat2D<T> varCols = gMat2D<T>::zeros(1,t);
-                    gVec<T>* sumCols_v = ytr.sum(COLUMNWISE);          // Vector containing the column-wise sum
-                    gMat2D<T> meanCols(sumCols_v->getData(), 1, t, 1); // Matrix containing the column-wise sum
-                    meanCols /= n_pretr;        // Matrix containing the column-wise mean
-                    
-                    if (verbose) cout << "Mean of the output columns: " << endl << meanCols << endl;
-                    
-                    for (int i = 0; i < n_pretr; i++)
-                    {
-                        gMat2D<T> ytri(ytr[i].getData(), 1, t, 1);
-                        varCols += (ytri - meanCols) * (ytri - meanCols); // NOTE: Temporary assignment
-                    }
-                    varCols /= n_pretr;     // Compute variance
-                    if (verbose) cout << "Variance of the output columns: " << endl << varCols << endl;
-
-                    // Initialize model
-                    cout << "Batch pretraining the RLS model with " << n_pretr << " samples." << endl;
-                    estimator.train(Xtr, ytr);
+                    // Compute the output variances and initialize model
+                    learner.train(Xtr, ytr);
                 }
                 
                 catch (gException& e)
@@ -329,22 +385,22 @@ public:
                         // Wait for input feature vector
                         if(verbose) cout << "Expecting input vector # " << j+1 << endl;
                         
-                        Bottle *bin = inVec.read();    // blocking call
+                        const Vector *bin = readSample();
                         
                         if (bin != 0)
                         {
-                            if(verbose) cout << "Got it!" << endl << bin->toString() << endl;
+                            if(verbose) cout << "Got it!" << endl << bin->toString().c_str() << endl;
 
                             //Store the received sample in gMat2D format for it to be compatible with gurls++
-                            for (int i = 0 ; i < bin->size() ; ++i)
+                            for (int i = 0 ; i < (int)bin->size() ; ++i)
                             {
                                 if ( i < d )
                                 {
-                                    Xtr(j,i) = bin->get(i).asDouble();
+                                    Xtr(j,i) = (*bin)[i];
                                 }
                                 else if ( (i>=d) && (i<d+t) )
                                 {
-                                    ytr(j, i - d ) = bin->get(i).asDouble();
+                                    ytr(j, i - d ) = (*bin)[i];
                                 }
                             }
                             if(verbose) cout << "Xtr[j]:" << endl << Xtr[j] << endl << "ytr[j]:" << endl << ytr[j] << endl;
@@ -356,25 +412,8 @@ public:
                     cout << "Xtr initialized!" << endl;
                     cout << "ytr initialized!" << endl;
                         
-                    // Compute variance for each output on the training set
-                    gMat2D<T> varCols = gMat2D<T>::zeros(1,t);
-                    gVec<T>* sumCols_v = ytr.sum(COLUMNWISE);          // Vector containing the column-wise sum
-                    gMat2D<T> meanCols(sumCols_v->getData(), 1, t, 1); // Matrix containing the column-wise sum
-                    meanCols /= n_pretr;        // Matrix containing the column-wise mean
-                    
-                    if (verbose) cout << "Mean of the output columns: " << endl << meanCols << endl;
-                    
-                    for (int i = 0; i < n_pretr; i++)
-                    {
-                        gMat2D<T> ytri(ytr[i].getData(), 1, t, 1);
-                        varCols += (ytri - meanCols) * (ytri - meanCols); // NOTE: Temporary assignment
-                    }
-                    varCols /= n_pretr;     // Compute variance
-                    if (verbose) cout << "Variance of the output columns: " << endl << varCols << endl;
-
-                    // Initialize model
-                    cout << "Batch pretraining the RLS model with " << n_pretr << " samples." << endl;
-                    estimator.train(Xtr, ytr);
+                    // Compute the output variances and initialize model
+                    learner.train(Xtr, ytr);
                 }
                 
                 catch (gException& e)
@@ -386,7 +425,7 @@ public:
             
             // Print detailed pretraining information
             if (verbose) 
-                estimator.getOpt().printAll();
+                learner.estimator.getOpt().printAll();
         }
         
         return true;
@@ -395,6 +434,8 @@ public:
     /************************************************************************/
     bool close()
     {        
+        shmIn.close();
+
         // Close ports
         inVec.close();
         printf("inVec closed\n");
@@ -440,34 +481,46 @@ public:
         if(verbose) cout << "updateModule #" << updateCount << endl;
 
 
-        // Recursive update support and storage variables declaration and initialization
-        gMat2D<T> Xnew(1,d);
-        gMat2D<T> ynew(1,t);
-        gVec<T> Xnew_v(d);
-        gVec<T> ynew_v(t);
-        gMat2D<T> *resptr = 0;
-        
         // Wait for input feature vector
         if(verbose) cout << "Expecting input vector" << endl;
         
-        Bottle *bin = inVec.read();    // blocking call
+        const Vector *bin = readSample();
+        
+        // Features appended upstream (RFmapper 'grow' command)
+        if (bin != 0 && (int)bin->size() > d + t)
+        {
+            learnerMutex.lock();
+            bool grown = learner.growFeatures((int)bin->size() - t);
+            d = learner.d;
+            learnerMutex.unlock();
+            if (!grown)
+            {
+                printf("Error: Features growth failed!\n");
+                return false;
+            }
+        }
+
+        // Recursive update support and storage variables
+        gMat2D<T> &Xnew = learner.Xnew;
+        gMat2D<T> &ynew = learner.ynew;
+        const gMat2D<T> *resptr = 0;
         
         if (bin != 0)
         {
-            if(verbose) cout << "Got it!" << endl << bin->toString() << endl;
+            if(verbose) cout << "Got it!" << endl << bin->toString().c_str() << endl;
 
             //Store the received sample in gMat2D format for it to be compatible with gurls++
 
-            for (int i = 0 ; i < bin->size() ; ++i)
+            for (int i = 0 ; i < (int)bin->size() ; ++i)
             {
                 if ( i < d )
                 {
-                    Xnew(0,i) = bin->get(i).asDouble();
+                    Xnew(0,i) = (*bin)[i];
                 }
                 else if ( (i>=d) && (i<d+t) )
                 {
 
-                    ynew(0, i - d ) = bin->get(i).asDouble();
+                    ynew(0, i - d ) = (*bin)[i];
                 }
             }
     
@@ -480,7 +533,7 @@ public:
             //-----------------------------------
             
             // Test on the incoming sample
-            resptr = estimator.eval(Xnew);
+            resptr = &learner.predict();
             
             Bottle& bpred = pred.prepare(); // Get a place to store things.
             bpred.clear();  // clear is important - b might be a reused object
@@ -500,56 +553,13 @@ public:
             Bottle& bperf = perf.prepare(); // Get a place to store things.
             bperf.clear();  // clear is important - b might be a reused object
     
-            if (perfType == "nMSE")     // WARNING: The estimated variance could be unreliable...
-            {
-                // Compute nMSE and store
-                //NOTE: In GURLS, "/" operator works like matlab's "\".
-                error += varCols / ( ynew - *resptr )*( ynew - *resptr ) ;   
-                gMat2D<T> tmp = error  / (updateCount);   // WARNING: Check
-                for (int i = 0 ; i < t ; ++i)
-                {
-                    bperf.addDouble(tmp(0 , i));
-                }
-            }
-            else if (perfType == "RMSE")
-            {
-                gMat2D<T> tmp(1,t);
-                tmp = ( ynew - *resptr )*( ynew - *resptr );
-                
-                //error = ( error * (updateCount-1) + sqrt(( ynew - *resptr )*( ynew - *resptr )) ) / updateCount;
-                
-                error = error * (updateCount-1);
-                for (int i = 0 ; i < ynew.cols() ; ++i)
-                    error(0,i) += sqrt(tmp(0,i));
-                error = error / updateCount;
-                
-/*                for (int i = 0 ; i < t ; ++i)
-                {
-                    bperf.addDouble(sqrt(MSE(0 , i)));
-                }      */
-
-                // WARNING: Temporary avg RMSE computation
-                
-                bperf.addDouble( (error(0 , 0) + error(0 , 1) + error(0 , 2))/ 3.0);    // Average MSE on forces
-                bperf.addDouble( (error(0 , 3) + error(0 , 4) + error(0 , 5))/ 3.0);    // Average MSE on torques
-            }
-            else if (perfType == "MSE")
-            {
-                //Compute MSE and store
-                
-                error = ( error * (updateCount-1) + ( ynew - *resptr )*( ynew - *resptr ) ) / updateCount;
-                for (int i = 0 ; i < t ; ++i)
-                {
-                    bperf.addDouble(error(0 , i));
-                }
-                
-            }
+            learner.updatePerf(updateCount, bperf);
             
             // Error storage matrix management
             // Update error storage matrix
             if (updateCount <= savedPerfNum)
             {
-                gVec<T> errRow = error[0];
+                gVec<T> errRow = learner.error[0];
                 storedError.setRow( errRow, updateCount-1);
             }
             
@@ -578,7 +588,9 @@ public:
             if(verbose) cout << "Now performing RRLS update" << endl;            
             if(verbose) cout << "Xnew" << Xnew << endl;            
             if(verbose) cout << "ynew" << ynew << endl;            
-            estimator.update(Xnew, ynew);
+            learnerMutex.lock();
+            learner.update();
+            learnerMutex.unlock();
             if(verbose) cout << "Update completed" << endl;            
         }
 
@@ -595,6 +607,7 @@ public:
     {
         inVec.interrupt();
         printf("inVec interrupted\n");
+        shmIn.interrupt();
 
         pred.interrupt();
         printf("pred interrupted\n");
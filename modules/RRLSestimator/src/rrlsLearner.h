@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _RRLS_LEARNER
+#define _RRLS_LEARNER
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include "gurls++/recrlswrapperchol.h"
+#include "gurls++/rlsprimal.h"
+#include "gurls++/primal.h"
+#include "gurls++/optmatrix.h"
+
+#include <yarp/os/Bottle.h>
+
+/************************************************************************/
+// Recursive RLS model with the test-then-train protocol of RRLSestimator:
+// each incoming sample is first predicted, the running performance is
+// updated and then the model is updated with the sample.
+class rrlsLearner
+{
+public:
+    typedef double T;
+
+    int d;
+    int t;
+    bool verbose;
+    std::string perfType;       // 'RMSE', 'MSE' or 'nMSE'
+    double growLambda;          // Regularization of the features added online
+
+    gurls::RecursiveRLSCholUpdateWrapper<T> estimator;
+    gurls::gMat2D<T> varCols;   // Column-wise variances of the outputs on the training set
+    gurls::gMat2D<T> error;     // Running performance measure
+
+    gurls::gMat2D<T> Xnew;      // [1 x d] current sample
+    gurls::gMat2D<T> ynew;      // [1 x t] current outputs
+    gurls::gMat2D<T> *yhat;     // [1 x t] prediction of the current sample
+    std::vector<T> varScratch;  // [d] forward substitution of variance()
+
+    rrlsLearner() : d(0), t(0), verbose(false), perfType("RMSE"), growLambda(1.0),
+                    estimator("recursiveRLSChol"), yhat(0)
+    {
+    }
+
+    ~rrlsLearner()
+    {
+        delete yhat;
+    }
+
+    // Allocate the sample and performance buffers
+    void init(int dim, int numOutputs)
+    {
+        d = dim;
+        t = numOutputs;
+        Xnew.resize(1,d);
+        ynew.resize(1,t);
+        error.resize(1,t);
+        error = gurls::gMat2D<T>::zeros(1, t);
+        varCols.resize(1,t);
+        varCols = gurls::gMat2D<T>::zeros(1, t);
+    }
+
+    // Batch training on the [n x d] inputs Xtr and [n x t] outputs ytr.
+    // Also computes the output variances used by the nMSE measure.
+    void train(gurls::gMat2D<T> &Xtr, gurls::gMat2D<T> &ytr)
+    {
+        int n = ytr.rows();
+
+        // Compute variance for each output on the training set
+        varCols = gurls::gMat2D<T>::zeros(1,t);
+        gurls::gVec<T>* sumCols_v = ytr.sum(gurls::COLUMNWISE);          // Vector containing the column-wise sum
+        gurls::gMat2D<T> meanCols(sumCols_v->getData(), 1, t, 1); // Matrix containing the column-wise sum
+        meanCols /= n;        // Matrix containing the column-wise mean
+
+        if (verbose) std::cout << "Mean of the output columns: " << std::endl << meanCols << std::endl;
+
+        for (int i = 0; i < n; i++)
+        {
+            gurls::gMat2D<T> ytri(ytr[i].getData(), 1, t, 1);
+            varCols += (ytri - meanCols) * (ytri - meanCols); // NOTE: Temporary assignment
+        }
+        varCols /= n;     // Compute variance
+        if (verbose) std::cout << "Variance of the output columns: " << std::endl << varCols << std::endl;
+
+        // Initialize model
+        std::cout << "Batch pretraining the RLS model with " << n << " samples." << std::endl;
+        estimator.train(Xtr, ytr);
+    }
+
+    // Copy a sample into the [1 x d] and [1 x t] buffers
+    void setSample(const double *x, const double *y)
+    {
+        for (int i = 0 ; i < d ; ++i)
+            Xnew(0,i) = x[i];
+        for (int i = 0 ; i < t ; ++i)
+            ynew(0,i) = y[i];
+    }
+
+    // Predict the outputs of the current sample
+    const gurls::gMat2D<T> &predict()
+    {
+        delete yhat;
+        yhat = estimator.eval(Xnew);
+        return *yhat;
+    }
+
+    // Update the running performance measure with the prediction of the
+    // updateCount-th sample and add it to bperf
+    void updatePerf(long unsigned int updateCount, yarp::os::Bottle &bperf)
+    {
+        if (perfType == "nMSE")     // WARNING: The estimated variance could be unreliable...
+        {
+            // Compute nMSE and store
+            //NOTE: In GURLS, "/" operator works like matlab's "\".
+            error += varCols / ( ynew - *yhat )*( ynew - *yhat ) ;
+            gurls::gMat2D<T> tmp = error  / (updateCount);   // WARNING: Check
+            for (int i = 0 ; i < t ; ++i)
+            {
+                bperf.addDouble(tmp(0 , i));
+            }
+        }
+        else if (perfType == "RMSE")
+        {
+            gurls::gMat2D<T> tmp(1,t);
+            tmp = ( ynew - *yhat )*( ynew - *yhat );
+
+            error = error * (updateCount-1);
+            for (int i = 0 ; i < ynew.cols() ; ++i)
+                error(0,i) += sqrt(tmp(0,i));
+            error = error / updateCount;
+
+            // WARNING: Temporary avg RMSE computation
+
+            bperf.addDouble( (error(0 , 0) + error(0 , 1) + error(0 , 2))/ 3.0);    // Average MSE on forces
+            bperf.addDouble( (error(0 , 3) + error(0 , 4) + error(0 , 5))/ 3.0);    // Average MSE on torques
+        }
+        else if (perfType == "MSE")
+        {
+            //Compute MSE and store
+
+            error = ( error * (updateCount-1) + ( ynew - *yhat )*( ynew - *yhat ) ) / updateCount;
+            for (int i = 0 ; i < t ; ++i)
+            {
+                bperf.addDouble(error(0 , i));
+            }
+        }
+    }
+
+    // Update the model with the current sample
+    void update()
+    {
+        estimator.update(Xnew, ynew);
+    }
+
+    // Predictive variance at the features phi, in units of the noise variance:
+    // phi' * (X'X + lambda*I)^-1 * phi = |R^-T * phi|^2, with the Cholesky
+    // factor R kept by the recursive update, at O(d^2). The information gain
+    // of observing the outputs at phi is t/2 * log(1 + variance).
+    // Returns false until the model is trained.
+    bool variance(const double *phi, double &v)
+    {
+        try
+        {
+            gurls::GurlsOptionsList &opt = const_cast<gurls::GurlsOptionsList&>(estimator.getOpt());
+            if (!opt.hasOpt("optimizer"))
+                return false;
+            const gurls::gMat2D<T> &R = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.R");
+
+            // Solve R' * z = phi, R' lower triangular
+            varScratch.resize(d);
+            v = 0.0;
+            for (int i = 0 ; i < d ; ++i)
+            {
+                T z = phi[i];
+                for (int k = 0 ; k < i ; ++k)
+                    z -= R(k,i) * varScratch[k];
+                z /= R(i,i);
+                varScratch[i] = z;
+                v += z * z;
+            }
+        }
+        catch (gurls::gException& e)
+        {
+            std::cout << e.getMessage() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /************************************************************************/
+    // Expand the model to newD features, appended after the current ones.
+    // Past samples are unknown on the new features, which are therefore
+    // treated as zero on them: the bordered block update of the Cholesky
+    // factor R of X'X + lambda*I
+    //      [ R  R12 ]   with  R12 = R^-T * X'Z = 0
+    //      [ 0  R22 ]         R22 = chol(Z'Z + growLambda*I) = sqrt(growLambda)*I
+    // costs a copy of R instead of a refactorization, and the weights of
+    // the new features start from zero.
+    bool growFeatures(int newD)
+    {
+        if (newD <= d)
+            return false;
+
+        std::cout << "Growing features from d = " << d << " to d = " << newD << std::endl;
+
+        try
+        {
+            // The optimizer state is only available once the model is trained
+            gurls::GurlsOptionsList &opt = const_cast<gurls::GurlsOptionsList&>(estimator.getOpt());
+            if (opt.hasOpt("optimizer"))
+            {
+                gurls::gMat2D<T> &R = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.R");
+                gurls::gMat2D<T> &b = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.b");
+                gurls::gMat2D<T> &W = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.W");
+
+                gurls::gMat2D<T> Rold(R);
+                gurls::gMat2D<T> bold(b);
+                gurls::gMat2D<T> Wold(W);
+
+                R.resize(newD, newD);
+                R = gurls::gMat2D<T>::zeros(newD, newD);
+                for (int j = 0 ; j < d ; ++j)
+                    for (int i = 0 ; i <= j ; ++i)
+                        R(i,j) = Rold(i,j);
+                for (int i = d ; i < newD ; ++i)
+                    R(i,i) = sqrt(growLambda);
+
+                b.resize(newD, t);
+                b = gurls::gMat2D<T>::zeros(newD, t);
+                W.resize(newD, t);
+                W = gurls::gMat2D<T>::zeros(newD, t);
+                for (int i = 0 ; i < d ; ++i)
+                {
+                    for (int j = 0 ; j < t ; ++j)
+                    {
+                        b(i,j) = bold(i,j);
+                        W(i,j) = Wold(i,j);
+                    }
+                }
+            }
+        }
+        catch (gurls::gException& e)
+        {
+            std::cout << e.getMessage() << std::endl;
+            return false;
+        }
+
+        d = newD;
+        Xnew.resize(1,d);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,747 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/**
+\defgroup RRLSpipeline
+
+Single-process iRRLS pipeline.
+
+Copyright (C) 2014 RobotCub Consortium
+
+Author: Raffaello Camoriano
+
+CopyPolicy: Released under the terms of the GNU GPL v2.0.
+
+\section intro_sec Description
+Runs the Synchronizer, Normalizer, RFmapper and RRLSestimator stages in a single
+process, handing each sample from one stage to the next through preallocated
+buffers instead of serializing it on the network. Each stage is configured by the
+configuration file of the corresponding module, so that the same setup can be
+deployed either as separate modules or with this runner.
+
+The front stages are driven by the F/T samples as in the Synchronizer: the port
+callbacks only queue the selected values, and an event loop aligns each F/T
+sample to the joint positions with the align, maxSkew, bufferLength, decimation
+and posDecimation keys of the Synchronizer configuration, so that the runner
+learns from the same samples as the distributed pipeline. Only the original
+layout [ q , qdot , qdotdot , F , T ] is supported (no streams).
+
+With pipelined set to 1, the learner stage runs in its own thread and the
+synchronization, normalization and mapping of the next sample overlap with the
+RRLS update of the current one. Samples are passed through a ring of queueLength
+preallocated slots.
+
+\author Raffaello Camoriano
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Thread.h>
+#include <yarp/os/Semaphore.h>
+#include <yarp/os/Mutex.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Vocab.h>
+#include <yarp/sig/Vector.h>
+
+#include "pvaEstimator.h"
+#include "timedBuffer.h"
+#include "normalization.h"
+#include "randomFeatures.h"
+#include "rrlsLearner.h"
+#include "lockFree.h"
+#include "jointSelector.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace gurls;
+
+typedef double T;
+
+/************************************************************************/
+// Input of the front stages: the selected values of each message are
+// queued with their timestamp and the event loop is woken up, as in the
+// Synchronizer. With arrival set, the local arrival time is queued as an
+// additional last value, to measure the latency of the pipeline.
+class sampleCollector : public jointSelector
+{
+private:
+    spscTimedQueue        queue;
+    Semaphore            *dataReady;
+    bool                  arrival;
+    Vector                buf;
+    long unsigned int     lost;         // Samples lost on a full queue
+
+    virtual void onSelected(double time, const Vector &x)
+    {
+        const double *v = x.data();
+        int n = (int)x.size();
+        if (arrival)
+        {
+            for (int i = 0 ; i < n ; ++i)
+                buf[i] = x[i];
+            buf[n] = Time::now();
+            v = buf.data();
+            ++n;
+        }
+
+        if (!queue.push(time, v, n))
+            atomicIncrement(lost);
+        dataReady->post();
+    }
+
+public:
+    sampleCollector(Semaphore *sem, bool stampArrival) : dataReady(sem), arrival(stampArrival), lost(0)
+    {
+    }
+
+    // Select the given values, one message every decim, queueing up to length samples
+    bool configure(const vector<int> &indices, int decim, int length)
+    {
+        if (!jointSelector::configure(indices, decim))
+            return false;
+        int n = (int)indices.size() + (arrival ? 1 : 0);
+        buf.resize(n, 0.0);
+        queue.resize(length, n);
+        return true;
+    }
+
+    // Consumer side, in the event loop
+    spscTimedQueue &samples()
+    {
+        return queue;
+    }
+
+    long unsigned int lostSamples() const
+    {
+        return atomicGet(lost);
+    }
+};
+
+/************************************************************************/
+// A preallocated sample handed from the front stages to the learner stage
+struct pipelineSlot
+{
+    Vector sample;      // [ q , qdot , qdotdot , F , T ], the first d normalized in place
+    Vector features;    // Random features of the normalized sample
+    double stamp;       // Time at which the F/T sample was received
+};
+
+class RRLSpipeline;
+
+/************************************************************************/
+// Learner stage thread, used when the pipeline is split across threads
+class learnerThread : public Thread
+{
+private:
+    RRLSpipeline *pipeline;
+
+public:
+    learnerThread(RRLSpipeline *p) : pipeline(p)
+    {
+    }
+
+    void run();
+    void onStop();
+};
+
+/************************************************************************/
+class RRLSpipeline: public RFModule
+{
+protected:
+
+    // Ports
+    sampleCollector          *posPort;      // Input joint positions [ q ]
+    sampleCollector          *ftPort;       // Input force/torque data [ F , T ], driving the pipeline
+    BufferedPort<Bottle>      pred;
+    BufferedPort<Bottle>      perf;
+    Port                      rpcPort;
+
+    // Synchronization, as in the Synchronizer
+    Semaphore dataReady;        // Posted by the port callbacks
+    pvaEstimator *estimator;
+    Vector q, qdot, qdotdot, PVA;
+    timedBuffer PVAHistory;     // Timestamped q, qdot, qdotdot
+    timedBuffer ftQueue;        // F/T samples (and arrival times) waiting to be aligned
+    Vector aligned;             // q, qdot, qdotdot aligned to a F/T sample
+    alignPolicy policy;
+    double maxSkew;             // Maximum time distance of the aligned samples [s]
+    long unsigned int dropped;  // F/T samples without positions within maxSkew
+
+    // Stages
+    normalization norm;
+    randomFeatures mapping;
+    rrlsLearner learner;
+
+    // Data
+    int xsz;                    // Number of joints
+    int dIn;                    // Number of input features (3*xsz)
+    int t;                      // Number of outputs
+    int verbose;
+
+    // Pretraining from the stream
+    int pretrain;
+    int n_pretr;
+    int pretrainCount;
+    gMat2D<T> Xtr;
+    gMat2D<T> ytr;
+
+    // Hand-off between the front stages and the learner stage
+    bool pipelined;
+    vector<pipelineSlot> slots;
+    int head;                   // Next slot filled by the front stages
+    int tail;                   // Next slot consumed by the learner stage
+    Semaphore freeSlots;
+    Semaphore fullSlots;
+    learnerThread *learnerStage;
+
+    // Statistics
+    Mutex statsMutex;
+    long unsigned int updateCount;  // Number of predicted samples
+    double totalLatency;            // Sum of the F/T to prediction latencies [s]
+    double maxLatency;
+
+    /************************************************************************/
+    // Load the configuration file of one of the pipeline modules
+    bool loadStageConfig(ResourceFinder &rf, const string &key, const string &defaultFile, Property &cfg)
+    {
+        string fileName = rf.check(key.c_str(),Value(defaultFile.c_str())).asString().c_str();
+        string path = rf.findFile(fileName.c_str()).c_str();
+        if (path == "" || !cfg.fromConfigFile(path.c_str()))
+        {
+            printf("Error: Could not load %s!\n", fileName.c_str());
+            return false;
+        }
+        cout << "Loaded " << path << endl;
+        return true;
+    }
+
+public:
+    /************************************************************************/
+    RRLSpipeline() : posPort(0), ftPort(0), dataReady(0), estimator(0), policy(ALIGN_LINEAR), maxSkew(0.1), dropped(0),
+                     pretrainCount(0), head(0), tail(0),
+                     freeSlots(0), fullSlots(0), learnerStage(0),
+                     updateCount(0), totalLatency(0.0), maxLatency(0.0)
+    {
+    }
+
+    // rpcPort commands handler
+    bool respond(const Bottle &      command,
+                 Bottle &      reply)
+    {
+        // Get command string
+        string receivedCmd = command.get(0).asString().c_str();
+        reply.clear();  // Clear reply bottle
+
+        if (receivedCmd == "help")
+        {
+            reply.addVocab(Vocab::encode("many"));
+            reply.addString("Available commands are:");
+            reply.addString("help");
+            reply.addString("stats");
+            reply.addString("quit");
+        }
+        else if (receivedCmd == "stats")
+        {
+            statsMutex.lock();
+            reply.addString("samples");
+            reply.addInt(updateCount);
+            reply.addString("avgLatency");
+            reply.addDouble(updateCount > 0 ? totalLatency / updateCount : 0.0);
+            reply.addString("maxLatency");
+            reply.addDouble(maxLatency);
+            statsMutex.unlock();
+            reply.addString("dropped");
+            reply.addInt((int)atomicGet(dropped));
+            reply.addString("lost");
+            reply.addInt((int)((posPort != 0 ? posPort->lostSamples() : 0) + (ftPort != 0 ? ftPort->lostSamples() : 0)));
+        }
+        else if (receivedCmd == "quit")
+        {
+            reply.addString("Quitting.");
+            return false; //note also this
+        }
+        else
+            reply.addString("Invalid command, type [help] for a list of accepted commands.");
+
+        return true;
+    }
+
+    bool configure(ResourceFinder &rf)
+    {
+        // request high resolution scheduling
+        Time::turboBoost();
+
+        string name=rf.find("name").asString().c_str();
+        setName(name.c_str());
+
+        verbose = rf.check("verbose",Value(0)).asInt();
+        pipelined = rf.check("pipelined",Value(0)).asInt() != 0;
+        int queueLength = rf.check("queueLength",Value(8)).asInt();
+
+        // Configurations of the pipeline modules
+        Property syncCfg, normCfg, mapperCfg, rrlsCfg;
+        if (!loadStageConfig(rf, "syncConfig", "Synchronizer_config.ini", syncCfg) ||
+            !loadStageConfig(rf, "normConfig", "Normalizer_config.ini", normCfg) ||
+            !loadStageConfig(rf, "mapperConfig", "RFmapper_config.ini", mapperCfg) ||
+            !loadStageConfig(rf, "rrlsConfig", "RRLSestimator_config.ini", rrlsCfg))
+            return false;
+
+        //------------------------------------------
+        //         Synchronizer
+        //------------------------------------------
+        if (syncCfg.check("streams"))
+        {
+            printf("Error: Only the layout [ q , qdot , qdotdot , F , T ] is supported, remove streams from the Synchronizer configuration!\n");
+            return false;
+        }
+        xsz = syncCfg.check("xsz",Value(4)).asInt();
+        t = syncCfg.check("t",Value(6)).asInt();
+
+        // Joints used on pos:i and position decimation, as in the Synchronizer
+        vector<int> joints;
+        Bottle *jointList = syncCfg.find("joints").asList();
+        for (int j = 0 ; j < xsz ; ++j)
+            joints.push_back(jointList != 0 ? jointList->get(j).asInt() : j);
+        if (jointList != 0 && jointList->size() != xsz)
+        {
+            printf("Error: %d joints listed, xsz = %d!\n", jointList->size(), xsz);
+            return false;
+        }
+        dIn = 3*xsz;
+
+        // Alignment of the positions to the F/T samples, with the defaults of the Synchronizer
+        string align = syncCfg.check("align",Value("linear")).asString().c_str();
+        if (!parseAlignPolicy(align, policy))
+        {
+            printf("Error: Alignment policy not available! Use nearest, linear or hold.\n");
+            return false;
+        }
+        maxSkew = syncCfg.check("maxSkew",Value(0.1)).asDouble();
+        int bufferLength = syncCfg.check("bufferLength",Value(100)).asInt();
+        int posDecimation = syncCfg.check("posDecimation",Value(1)).asInt();
+        int ftDecimation = syncCfg.check("decimation",Value(1)).asInt();
+        if (maxSkew <= 0.0 || bufferLength < 2 || posDecimation < 1 || ftDecimation < 1)
+        {
+            printf("Error: maxSkew must be positive, bufferLength at least 2 and decimations at least 1!\n");
+            return false;
+        }
+        estimator = new pvaEstimator(syncCfg);
+        q.resize(xsz, 0.0);
+        PVA.resize(dIn, 0.0);
+        PVAHistory.resize(bufferLength, dIn);
+        ftQueue.resize(bufferLength, t + 1);
+
+        //------------------------------------------
+        //         Normalizer
+        //------------------------------------------
+        if (normCfg.check("d",Value(12)).asInt() != dIn)
+        {
+            printf("Error: Normalizer d must be 3*xsz = %d!\n", dIn);
+            return false;
+        }
+        if (!norm.configure(normCfg, dIn))
+            return false;
+
+        //------------------------------------------
+        //         RFmapper
+        //------------------------------------------
+        Bottle &mapperGeneral = mapperCfg.findGroup("general");
+        mapping.d = mapperGeneral.check("d",Value(0)).asInt();
+        mapping.numRF = mapperGeneral.check("numRF",Value(0)).asInt();
+        if (mapping.d != dIn || mapping.numRF <= 0 || mapperGeneral.check("t",Value(0)).asInt() != t)
+        {
+            printf("Error: Inconsistent RFmapper dimensionalities!\n");
+            return false;
+        }
+        if (!mapping.configure(mapperGeneral, rf.getContextPath() + "/proj/"))
+            return false;
+
+        //------------------------------------------
+        //         RRLSestimator
+        //------------------------------------------
+        int d = rrlsCfg.check("d",Value(0)).asInt();
+        if (d != mapping.outDim() || rrlsCfg.check("t",Value(0)).asInt() != t)
+        {
+            printf("Error: RRLSestimator d must be the number of random features (%d)!\n", mapping.outDim());
+            return false;
+        }
+        learner.verbose = verbose != 0;
+        learner.perfType = rrlsCfg.check("perf",Value("RMSE")).asString().c_str();
+        if (learner.perfType != "MSE" && learner.perfType != "RMSE" && learner.perfType != "nMSE")
+        {
+            printf("Error: Inconsistent performance measure! Set to RMSE.\n");
+            learner.perfType = "RMSE";
+        }
+        learner.growLambda = rrlsCfg.check("growLambda",Value(1.0)).asDouble();
+        learner.init(d, t);
+
+        pretrain = rrlsCfg.check("pretrain",Value(0)).asInt();
+        n_pretr = rrlsCfg.check("n_pretr",Value(2)).asInt();
+        if (pretrain == 1)
+        {
+            string pretr_type = rrlsCfg.check("pretr_type",Value("fromStream")).asString().c_str();
+            if (pretr_type != "fromStream")
+                cout << "Warning: only pretraining from the stream is supported in a single process" << endl;
+            Xtr.resize(n_pretr, d);
+            ytr.resize(n_pretr, t);
+        }
+
+        //------------------------------------------
+        //         Sample slots
+        //------------------------------------------
+        if (queueLength < 1)
+            queueLength = 1;
+        slots.resize(pipelined ? queueLength : 1);
+        for (size_t k = 0 ; k < slots.size() ; ++k)
+        {
+            slots[k].sample.resize(dIn + t, 0.0);
+            slots[k].features.resize(mapping.outDim(), 0.0);
+        }
+
+        // Print Configuration
+        cout << endl << "-------------------------" << endl;
+        cout << "Configuration parameters:" << endl << endl;
+        cout << "xsz = " << xsz << ", t = " << t << endl;
+        cout << "align = " << align << ", maxSkew = " << maxSkew << " s, posDecimation = " << posDecimation
+             << ", decimation = " << ftDecimation << endl;
+        cout << "Normalization: " << norm.type << endl;
+        cout << "numRF = " << mapping.numRF << ", output features: " << mapping.outDim() << endl;
+        cout << "perf = " << learner.perfType << endl;
+        if (pretrain == 1)
+            printf("Pretraining from stream with %d samples\n", n_pretr);
+        if (pipelined)
+            cout << "Pipelined, " << queueLength << " slots" << endl;
+        cout << "-------------------------" << endl << endl;
+
+        if (pipelined)
+        {
+            for (size_t k = 0 ; k < slots.size() ; ++k)
+                freeSlots.post();
+
+            learnerStage = new learnerThread(this);
+            if (!learnerStage->start())
+            {
+                printf("Error: Could not start the learner thread!\n");
+                return false;
+            }
+        }
+
+        // Open ports
+        string fwslash="/";
+        vector<int> ftValues;
+        for (int i = 0 ; i < t ; ++i)
+            ftValues.push_back(i);
+        posPort = new sampleCollector(&dataReady, false);
+        ftPort = new sampleCollector(&dataReady, true);
+        if (!posPort->configure(joints, posDecimation, bufferLength) || !ftPort->configure(ftValues, ftDecimation, bufferLength))
+        {
+            printf("Error: Joint indices must not be negative!\n");
+            return false;
+        }
+        posPort->open(fwslash+name+"/pos:i");
+        ftPort->open(fwslash+name+"/ft:i");
+        pred.open((fwslash+name+"/pred:o").c_str());
+        perf.open((fwslash+name+"/perf:o").c_str());
+        rpcPort.open((fwslash+name+"/rpc:i").c_str());
+
+        // Attach rpcPort to the respond() method
+        attach(rpcPort);
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool close()
+    {
+        // Stop the learner stage before closing its output ports
+        if (learnerStage != 0)
+        {
+            learnerStage->stop();
+            delete learnerStage;
+            learnerStage = 0;
+        }
+
+        if (posPort != 0)
+        {
+            posPort->close();
+            delete posPort;
+            posPort = 0;
+        }
+        if (ftPort != 0)
+        {
+            ftPort->close();
+            delete ftPort;
+            ftPort = 0;
+        }
+        delete estimator;
+        estimator = 0;
+        pred.close();
+        perf.close();
+        rpcPort.close();
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool interruptModule()
+    {
+        if (posPort != 0)
+            posPort->interrupt();
+        if (ftPort != 0)
+            ftPort->interrupt();
+        pred.interrupt();
+        perf.interrupt();
+        rpcPort.interrupt();
+
+        // Wake up the event loop
+        dataReady.post();
+
+        return true;
+    }
+
+    /************************************************************************/
+    // Event loop: wait for the port callbacks
+    double getPeriod()
+    {
+        return 0.0;
+    }
+
+    /************************************************************************/
+    bool updateModule()
+    {
+        dataReady.waitWithTimeout(1.0);
+
+        collect();
+        process();
+        return true;
+    }
+
+    /************************************************************************/
+    // Move the queued positions to their history (estimating the derivatives)
+    // and the queued F/T samples to ftQueue
+    void collect()
+    {
+        spscTimedQueue &posSamples = posPort->samples();
+        while (!posSamples.empty())
+        {
+            double time = posSamples.frontTime();
+            const Vector &x = posSamples.front();
+            for (int i = 0 ; i < xsz ; ++i)
+                q[i] = x[i];
+            posSamples.pop();
+
+            estimator->estimate(q, time, qdot, qdotdot);
+            PVA.setSubvector( 0 , q );
+            PVA.setSubvector( xsz , qdot );
+            PVA.setSubvector( 2*xsz , qdotdot );
+            PVAHistory.push(time, PVA.data(), dIn);
+        }
+
+        spscTimedQueue &ftSamples = ftPort->samples();
+        while (!ftSamples.empty())
+        {
+            ftQueue.push(ftSamples.frontTime(), ftSamples.front().data(), t + 1);
+            ftSamples.pop();
+        }
+    }
+
+    /************************************************************************/
+    // Feed the front stages with the queued F/T samples for which the
+    // positions can be aligned, with the policy of the Synchronizer
+    void process()
+    {
+        while (ftQueue.size() > 0)
+        {
+            double tFT = ftQueue.timeAt(0);
+
+            // Stop waiting for newer positions once F/T samples more than maxSkew newer have arrived
+            bool force = ftQueue.newestTime() - tFT > maxSkew;
+            int res = PVAHistory.align(tFT, policy, maxSkew, force, aligned);
+            if (res == ALIGN_WAIT)
+                break;
+
+            if (res == ALIGN_OK)
+                frontStages(aligned, ftQueue.at(0));
+            else
+                atomicIncrement(dropped);
+
+            ftQueue.popFront();
+        }
+    }
+
+    /************************************************************************/
+    // Front stages: normalization and mapping of a synchronized sample,
+    // then hand-off to the learner stage. ft holds the F/T values followed
+    // by their arrival time.
+    void frontStages(const Vector &pva, const Vector &ft)
+    {
+        if (pipelined)
+            freeSlots.wait();
+        pipelineSlot &slot = slots[head];
+        slot.stamp = ft[t];
+
+        // Synchronizer
+        double *sample = slot.sample.data();
+        for (int i = 0 ; i < dIn ; ++i)
+            sample[i] = pva[i];
+        for (int i = 0 ; i < t ; ++i)
+            sample[dIn + i] = ft[i];
+
+        // Normalizer, in place
+        norm.update(sample);
+        norm.apply(sample, sample);
+
+        // RFmapper
+        mapping.mapSample(sample, slot.features.data());
+
+        if (pipelined)
+        {
+            head = (head + 1) % slots.size();
+            fullSlots.post();
+        }
+        else
+            learn(slot);
+    }
+
+    /************************************************************************/
+    // Learner stage: pretraining, or prediction, performance and update
+    void learn(const pipelineSlot &slot)
+    {
+        const double *x = slot.features.data();
+        const double *y = slot.sample.data() + dIn;
+
+        if (pretrain == 1 && pretrainCount < n_pretr)
+        {
+            for (int i = 0 ; i < learner.d ; ++i)
+                Xtr(pretrainCount, i) = x[i];
+            for (int i = 0 ; i < t ; ++i)
+                ytr(pretrainCount, i) = y[i];
+
+            if (++pretrainCount == n_pretr)
+            {
+                try
+                {
+                    learner.train(Xtr, ytr);
+                }
+                catch (gException& e)
+                {
+                    cout << e.getMessage() << endl;
+                }
+            }
+            return;
+        }
+
+        learner.setSample(x, y);
+
+        // Prediction
+        const gMat2D<T> &yhat = learner.predict();
+
+        Bottle& bpred = pred.prepare();
+        bpred.clear();
+        for (int i = 0 ; i < t ; ++i)
+            bpred.addDouble(yhat(0 , i));
+        pred.write();
+
+        double latency = Time::now() - slot.stamp;
+
+        statsMutex.lock();
+        ++updateCount;
+        totalLatency += latency;
+        if (latency > maxLatency)
+            maxLatency = latency;
+        long unsigned int count = updateCount;
+        statsMutex.unlock();
+
+        // Performance
+        Bottle& bperf = perf.prepare();
+        bperf.clear();
+        learner.updatePerf(count, bperf);
+        if(verbose) printf("Sending %s measurement: %s\n", learner.perfType.c_str(), bperf.toString().c_str());
+        perf.write();
+
+        // Update
+        learner.update();
+    }
+
+    /************************************************************************/
+    // Learner stage loop, run by learnerThread
+    void learnerLoop(Thread *thread)
+    {
+        while (true)
+        {
+            fullSlots.wait();
+            if (thread->isStopping())
+                break;
+
+            learn(slots[tail]);
+            tail = (tail + 1) % slots.size();
+
+            freeSlots.post();
+        }
+    }
+
+    /************************************************************************/
+    void wakeLearner()
+    {
+        fullSlots.post();
+    }
+};
+
+/************************************************************************/
+void learnerThread::run()
+{
+    pipeline->learnerLoop(this);
+}
+
+/************************************************************************/
+void learnerThread::onStop()
+{
+    // Wake up the thread so that it can notice the stop request
+    pipeline->wakeLearner();
+}
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    Network yarp;
+    if (!yarp.checkNetwork())
+    {
+        printf("YARP server not available!\n");
+        return -1;
+    }
+
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultConfigFile("RRLSpipeline_config.ini");
+    rf.setDefaultContext("iRRLS");
+    rf.setDefault("name","RRLSpipeline");
+    rf.configure(argc,argv);
+
+    RRLSpipeline mod;
+    return mod.runModule(rf);
+}
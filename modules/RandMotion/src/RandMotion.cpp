@@ -29,6 +29,7 @@
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <cmath>
 #include <istream>
 #include <sstream>
 
@@ -38,6 +39,8 @@
 #include <yarp/os/BufferedPort.h>
 #include <yarp/sig/Vector.h>
 #include <yarp/os/Vocab.h>
+#include <yarp/os/Thread.h>
+#include <yarp/os/Time.h>
 #include <yarp/math/Math.h>
 #include <yarp/math/Rand.h>
 #include <yarp/conf/system.h>
@@ -47,6 +50,13 @@ YARP_DECLARE_DEVICES(icubmod)
 
 #include <iCub/ctrl/math.h>
 
+#include "targetSampler.h"
+#include "reachabilityGrid.h"
+#include "lockFree.h"
+
+// Hard lower bound of the motion durations [s]
+#define MIN_MOTION_DURATION 1.0
+
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::sig;
@@ -55,6 +65,62 @@ using namespace yarp::dev;
 using namespace iCub::ctrl;
 
 
+/************************************************************************/
+// Queries the IK solver on a subset of the nodes of the reachability grid
+// (one node every numWorkers), through a Cartesian client of its own, so
+// that several workers keep the solver busy while waiting for the replies
+class reachWorker : public Thread
+{
+private:
+    reachabilityGrid   *grid;
+    string              remote;
+    string              local;
+    int                 first;
+    int                 step;
+    PolyDriver          client;
+    ICartesianControl  *icart;
+
+public:
+    long unsigned int   done;           // Nodes queried, read atomically by the module for the progress
+
+    reachWorker(reachabilityGrid *g, const string &remotePort, const string &localPort, int k, int numWorkers) :
+        grid(g), remote(remotePort), local(localPort), first(k), step(numWorkers), icart(0), done(0)
+    {
+    }
+
+    bool threadInit()
+    {
+        Property option("(device cartesiancontrollerclient)");
+        option.put("remote",remote.c_str());
+        option.put("local",local.c_str());
+        if (!client.open(option) || !client.isValid())
+        {
+            printf("Error: Could not open the Cartesian client %s!\n", local.c_str());
+            return false;
+        }
+        client.view(icart);
+        return true;
+    }
+
+    void run()
+    {
+        Vector xd, xdhat, odhat, qdhat;
+        for (int i = first ; i < grid->numNodes() && !isStopping() ; i += step)
+        {
+            grid->node(i, xd);
+            bool ok = icart->askForPosition(xd,xdhat,odhat,qdhat);
+            grid->setNode(i, ok && norm(xd - xdhat) <= grid->getTolerance(), qdhat);
+            atomicIncrement(done);
+        }
+    }
+
+    void threadRelease()
+    {
+        client.close();
+    }
+};
+
+
 /************************************************************************/
 class RandMotion: public RFModule
 {
@@ -71,6 +137,41 @@ protected:
     Vector                      boxCenterPos;   // Position of the box's center [ xCenter, yCenter, zCenter ]
     Vector                      boxSideSizes;   // Dimensions of the box [ xSize, ySize, zSize ]
     vector<Vector>              boxVertexes;    // vector containing the box vertexes
+
+    targetSampler               sampler;        // Generator of the targets inside the box
+    coverageGrid                coverage;       // Cells of the box visited by the targets
+    reachabilityGrid            reach;          // Reachable cells of the box, the targets are drawn inside them
+    bool                        useReach;
+    int                         numTargets;
+    double                      minDuration;    // Bounds of the random motion durations [s]
+    double                      maxDuration;
+
+    // Motion scheduler
+    Vector                      nextTarget;     // Prepared while the current motion runs
+    double                      nextDuration;
+    bool                        moving;         // A motion has been issued and is not done
+    double                      motionStart;
+    double                      motionDuration;
+    double                      blendProgress;  // Fraction of a motion after which the next target is issued
+    double                      pollPeriod;     // [s]
+    bool                        paused;         // Set atomically by the 'stop' rpc command
+    double                      idleTime;       // Total time spent at rest between motions [s]
+    double                      startTime;
+    
+    // Active exploration: the next target is the candidate of largest
+    // expected information gain for the model learnt by RRLSestimator
+    bool                        explore;
+    int                         exploreCandidates;
+    int                         explorePathPoints;  // States scored along the path to a candidate
+    vector<int>                 exploreJoints;  // Joints of the model in the IK configurations
+    targetSampler               candidateSampler;
+    Port                        normRpc;        // To Normalizer, RFmapper and RRLSestimator rpc:i
+    Port                        mapRpc;
+    Port                        estRpc;
+    double                      exploreTimeout; // Maximum wait for each rpc reply [s]
+    Vector                      nextConfig;     // Model joints at the prepared target [deg]
+    int                         numExplored;    // Targets chosen by information gain
+    double                      lastGain;
     
     PolyDriver                  clientCartCtrl;
     ICartesianControl          *icart;   
@@ -84,17 +185,152 @@ protected:
         return ret;
     }
     
-    void handToCenter()
+    // Model joints of the IK configuration at xd, interpolated from the reachability grid
+    bool modelConfiguration(const Vector &xd, Vector &q)
     {
-        if (verbose) cout << "handToCenter() called" << endl;
+        Vector qChain;
+        if (!reach.configuration(xd, qChain))
+            return false;
+        q.resize(exploreJoints.size());
+        for (size_t j = 0 ; j < exploreJoints.size() ; ++j)
+        {
+            if (exploreJoints[j] >= (int)qChain.size())
+                return false;
+            q[j] = qChain[exploreJoints[j]];
+        }
+        return true;
+    }
 
-        Vector xd(3)/*, od(4)*/; // Target position
-        
-        xd[0]= boxCenterPos[0] + Rand::scalar( -boxSideSizes[0] , boxSideSizes[0] );
-        xd[1]= boxCenterPos[1] + Rand::scalar( -boxSideSizes[1] , boxSideSizes[1] );
-        xd[2]= boxCenterPos[2] + Rand::scalar( -boxSideSizes[2] , boxSideSizes[2] );
+    // Send cmd on an rpc port and check that the reply is a list of expected lists.
+    // The ports have a reply timeout, so that a stalled module only makes the
+    // exploration fall back to the sampler instead of blocking the scheduler
+    bool query(Port &port, Bottle &cmd, Bottle &reply, int expected)
+    {
+        reply.clear();
+        if (port.getOutputCount() == 0 || !port.write(cmd, reply))
+            return false;
+        if (reply.size() != expected)
+        {
+            if (verbose) cout << "Unexpected rpc reply: " << reply.toString().c_str() << endl;
+            return false;
+        }
+        for (int i = 0 ; i < reply.size() ; ++i)
+            if (reply.get(i).asList() == 0)
+                return false;
+        return true;
+    }
+
+    // Choose among exploreCandidates reachable targets the one whose motion
+    // from the current target is most informative for the model. The
+    // states [ q qdot qdotdot ] along the minimum jerk path in joint space are
+    // normalized by Normalizer, mapped by RFmapper and scored by the predictive
+    // variance v of RRLSestimator; the gain of a path is the sum of
+    // log(1 + v) / 2 over its states.
+    bool exploreTarget()
+    {
+        int n = (int)exploreJoints.size();
+        int P = explorePathPoints;
+        vector<Vector> targets(exploreCandidates), configs(exploreCandidates);
+        const Vector &start = nextConfig;      // The target being issued
+
+        Bottle cmd, reply;
+        cmd.addString("apply");
+        for (int c = 0 ; c < exploreCandidates ; ++c)
+        {
+            candidateSampler.next(targets[c], &reach);
+            if (!modelConfiguration(targets[c], configs[c]))
+                return false;
+
+            for (int p = 1 ; p <= P ; ++p)
+            {
+                double tau = (double)p / P;
+                double tau2 = tau * tau, tau3 = tau2 * tau;
+                double sp = tau3 * (10.0 - 15.0 * tau + 6.0 * tau2);
+                double sd = tau2 * (30.0 - 60.0 * tau + 30.0 * tau2) / nextDuration;
+                double sdd = tau * (60.0 - 180.0 * tau + 120.0 * tau2) / (nextDuration * nextDuration);
+
+                Bottle &state = cmd.addList();
+                for (int j = 0 ; j < n ; ++j)
+                    state.addDouble(start.size() == (size_t)n ? start[j] + sp * (configs[c][j] - start[j]) : configs[c][j]);
+                for (int j = 0 ; j < n ; ++j)
+                    state.addDouble(start.size() == (size_t)n ? sd * (configs[c][j] - start[j]) : 0.0);
+                for (int j = 0 ; j < n ; ++j)
+                    state.addDouble(start.size() == (size_t)n ? sdd * (configs[c][j] - start[j]) : 0.0);
+            }
+        }
+
+        // Normalize, map, then score
+        if (!query(normRpc, cmd, reply, exploreCandidates * P))
+            return false;
+        cmd.clear();
+        cmd.addString("map");
+        cmd.append(reply);
+        if (!query(mapRpc, cmd, reply, exploreCandidates * P))
+            return false;
+        cmd.clear();
+        cmd.addString("variance");
+        cmd.append(reply);
+        if (!query(estRpc, cmd, reply, 1) || reply.get(0).asList()->size() != exploreCandidates * P)
+            return false;
+
+        // Candidates with an invalid (negative or NaN) variance are skipped
+        Bottle *var = reply.get(0).asList();
+        int best = -1;
+        double bestGain = -1.0;
+        for (int c = 0 ; c < exploreCandidates ; ++c)
+        {
+            double gain = 0.0;
+            bool valid = true;
+            for (int p = 0 ; p < P && valid ; ++p)
+            {
+                double v = var->get(c * P + p).asDouble();
+                valid = v >= 0.0 && v <= 1e300;
+                if (valid)
+                    gain += 0.5 * log(1.0 + v);
+            }
+            if (valid && gain > bestGain)
+            {
+                bestGain = gain;
+                best = c;
+            }
+        }
+        if (best < 0)
+        {
+            if (verbose) cout << "No candidate target with a valid variance" << endl;
+            return false;
+        }
+
+        nextTarget = targets[best];
+        nextConfig = configs[best];
+        atomicSet(lastGain, bestGain);
+        atomicSet(numExplored, numExplored + 1);
+        if (verbose) cout << "Explored target, information gain " << bestGain << endl;
+        return true;
+    }
+
+    // Draw the next target and duration, while the current motion runs
+    void prepareNextTarget()
+    {
+        nextDuration = Rand::scalar( minDuration , maxDuration );
+        if (explore && exploreTarget())
+            return;
+
+        // Space-filling sequence, also while the model cannot be queried
+        sampler.next(nextTarget, useReach ? &reach : 0);
+        if (explore)
+            modelConfiguration(nextTarget, nextConfig);
+    }
+
+    // Send the prepared target to the controller without waiting for the motion
+    void handToTarget()
+    {
+        if (verbose) cout << "handToTarget() called" << endl;
 
-        if (verbose) cout << "Target position: " << xd.toString() << endl;
+        coverage.add(nextTarget);
+        atomicSet(numTargets, numTargets + 1);
+
+        if (verbose) cout << "Target position: " << nextTarget.toString() << endl;
+        if (verbose) cout << "Motion duration: " << nextDuration << " secs" << endl;
 
 
          //Target orientation
@@ -109,29 +345,110 @@ protected:
 //         Matrix R = Ry*Rx;                 // compose the two rotations keeping the order
 //         od = iCub::ctrl::dcm2axis(R);     // from rotation matrix back to the axis/angle notation    
 /*
-        icart->goToPoseSync(xd,od);   // send request and wait for reply
-        icart->waitMotionDone(0.04);*/
+        icart->goToPose(xd,od);*/
 
-        double randDuration = Rand::scalar( 3.0 , 7.0 );    //TODO: minduration, maxduration. NOTE: set minimum hard-coded threshold
+        bool isok = icart->goToPosition(nextTarget , nextDuration);   // send request, do not wait for the motion
+        if (!isok)  cout << "Controller answer: Failure!" << endl;
+        else if (verbose) cout << "goToPosition cmd issued" << endl;
 
-        if (verbose) cout << "Motion duration: " << randDuration << " secs" << endl;
+        motionStart = Time::now();
+        motionDuration = nextDuration;
+        moving = true;
 
-        bool isok = icart->goToPositionSync(xd , randDuration);   // send request and wait for reply
-        if (verbose) cout << "goToPositionSync cmd issued" << endl;
-        if (!isok)  cout << "Controller answer: Failure!" << endl;
+        // The following target is ready before this motion ends
+        prepareNextTarget();
+    }
 
-        isok = icart->waitMotionDone(0.1);
-        if (!isok)  cout << "waitMotionDone: Failure!" << endl;
-        else if (verbose) cout << "goToPositionSync cmd completed" << endl;\
+    // Poll the current motion: the next target is issued as soon as the
+    // motion has reached blendProgress of its duration, or is done
+    void scheduleMotions()
+    {
+        if (moving)
+        {
+            bool done = false;
+            icart->checkMotionDone(&done);
+            double now = Time::now();
+            double progress = (now - motionStart) / motionDuration;
+            if (!done && progress < blendProgress)
+                return;
+
+            // The arm rested at the target until this poll
+            if (done && now > motionStart + motionDuration)
+                atomicSet(idleTime, idleTime + now - (motionStart + motionDuration));
+        }
 
-        return;
+        handToTarget();
     }
     
+    // Query the IK solver on the nodes of the reachability grid, with
+    // numWorkers clients in parallel
+    bool buildReachability(int numWorkers)
+    {
+        vector<reachWorker*> workers;
+        for (int k = 0 ; k < numWorkers ; ++k)
+        {
+            ostringstream local;
+            local << "/client/" << armSide << "_arm/reach" << k;
+            workers.push_back(new reachWorker(&reach, "/" + robot + "/cartesianController/" + armSide + "_arm",
+                                              local.str(), k, numWorkers));
+        }
+
+        bool ok = true;
+        for (int k = 0 ; k < numWorkers && ok ; ++k)
+            ok = workers[k]->start();
+
+        double t0 = Time::now();
+        for (bool running = ok ; running ; )
+        {
+            Time::delay(1.0);
+            running = false;
+            long unsigned int done = 0;
+            for (int k = 0 ; k < numWorkers ; ++k)
+            {
+                running = running || workers[k]->isRunning();
+                done += atomicGet(workers[k]->done);
+            }
+            cout << "Reachability: " << done << " / " << reach.numNodes() << " nodes" << endl;
+        }
+
+        for (int k = 0 ; k < numWorkers ; ++k)
+        {
+            workers[k]->stop();
+            delete workers[k];
+        }
+
+        if (ok)
+        {
+            reach.update();
+            cout << "Reachability grid built in " << Time::now() - t0 << " s" << endl;
+        }
+        return ok;
+    }
+
 public:
     /************************************************************************/
     RandMotion()
     {
         icart = 0;
+        numTargets = 0;
+        useReach = false;
+        explore = false;
+        exploreCandidates = 32;
+        explorePathPoints = 3;
+        exploreTimeout = 0.1;
+        numExplored = 0;
+        lastGain = 0.0;
+        minDuration = 3.0;
+        maxDuration = 7.0;
+        nextDuration = 0.0;
+        moving = false;
+        motionStart = 0.0;
+        motionDuration = 1.0;
+        blendProgress = 0.9;
+        pollPeriod = 0.05;
+        paused = false;
+        idleTime = 0.0;
+        startTime = 0.0;
     }
 
     /************************************************************************/    
@@ -153,8 +470,44 @@ public:
             reply.addVocab(Vocab::encode("many"));
             reply.addString("Available commands are:");
             reply.addString("help");
+            reply.addString("stats");
+            reply.addString("stop");
+            reply.addString("start");
             reply.addString("quit");
         }
+        else if (receivedCmd == "stats")
+        {
+            // Number of targets and fraction of the box cells visited. The
+            // counters are updated by updateModule and read atomically.
+            reply.addString("sampler");
+            reply.addString(sampler.getType().c_str());
+            reply.addString("targets");
+            reply.addInt(atomicGet(numTargets));
+            reply.addString("coverage");
+            reply.addDouble(coverage.coverage());
+            reply.addString("reachable");
+            reply.addDouble(useReach ? reach.fraction() : 1.0);
+            reply.addString("explored");
+            reply.addInt(atomicGet(numExplored));
+            reply.addString("gain");
+            reply.addDouble(atomicGet(lastGain));
+
+            // Fraction of the time the arm has been at rest waiting for a target
+            double elapsed = Time::now() - atomicGet(startTime);
+            reply.addString("idle");
+            reply.addDouble(elapsed > 0.0 ? atomicGet(idleTime) / elapsed : 0.0);
+        }
+        else if (receivedCmd == "stop")
+        {
+            // Applied by updateModule, which owns the controller
+            atomicSet(paused, true);
+            reply.addString("Stopping the motions.");
+        }
+        else if (receivedCmd == "start")
+        {
+            atomicSet(paused, false);
+            reply.addString("Resuming the motions.");
+        }
         else if (receivedCmd == "quit")
         {
             reply.addString("Quitting.");
@@ -246,6 +599,37 @@ public:
         }        
         std::cout << "Got box sides sizes" << std::endl;
 
+        // Target generator over the box and motion durations
+        string samplerType = rf.check("sampler",Value("sobol")).asString().c_str();
+        if (!sampler.configure(samplerType, boxCenterPos, boxSideSizes,
+                               rf.check("lhsBatch",Value(16)).asInt(), rf.check("farthestCandidates",Value(50)).asInt()))
+        {
+            printf("Error: Invalid target sampler! Use uniform, sobol, lhs or farthest, with positive lhsBatch and farthestCandidates.\n");
+            return false;
+        }
+        coverage.configure(boxCenterPos, boxSideSizes, rf.check("coverageCells",Value(5)).asInt());
+
+        blendProgress = rf.check("blendProgress",Value(0.9)).asDouble();
+        pollPeriod = rf.check("pollPeriod",Value(0.05)).asDouble();
+        if (blendProgress <= 0.0 || blendProgress > 1.0 || pollPeriod <= 0.0)
+        {
+            printf("Error: blendProgress must be in (0, 1] and pollPeriod positive!\n");
+            return false;
+        }
+
+        minDuration = rf.check("minDuration",Value(3.0)).asDouble();
+        maxDuration = rf.check("maxDuration",Value(7.0)).asDouble();
+        if (minDuration < MIN_MOTION_DURATION)
+        {
+            cout << "Warning: minDuration below " << MIN_MOTION_DURATION << " s, setting minDuration = " << MIN_MOTION_DURATION << endl;
+            minDuration = MIN_MOTION_DURATION;
+        }
+        if (maxDuration < minDuration)
+        {
+            cout << "Warning: maxDuration below minDuration, setting maxDuration = " << minDuration << endl;
+            maxDuration = minDuration;
+        }
+
         // Check reachability
         
         // Open Cartesian interface
@@ -309,19 +693,82 @@ public:
             cout << "]" << endl;
         }
         
-        // Check reachability for each vertex
-        Vector xdhat, odhat, qdhat;     // Response vectors
-        for ( int i = 0 ; i < 8 ; ++i )
+        double reachTolerance = rf.check("reachTolerance",Value(0.005)).asDouble();
+        int reachCells = rf.check("reachCells",Value(8)).asInt();
+        useReach = reachCells > 0;
+        if (useReach)
         {
-            isOk = icart->askForPosition(boxVertexes[i],xdhat,odhat,qdhat);
-        }
+            // Reachability grid, built once per robot, arm and box, then loaded from the cache
+            string reachFile = rf.check("reachFile",Value(("reachability_" + robot + "_" + armSide + ".txt").c_str())).asString().c_str();
+            string reachPath = reachFile[0] == '/' ? reachFile : string(rf.getHomeContextPath().c_str()) + "/" + reachFile;
+            reach.configure(boxCenterPos, boxSideSizes, reachCells, reachTolerance, robot + " " + armSide);
+
+            bool rebuild = rf.check("reachRebuild",Value(0)).asInt() != 0;
+            if (!rebuild && reach.load(reachPath))
+                cout << "Reachability grid loaded from " << reachPath << endl;
+            else
+            {
+                cout << "Building the reachability grid, " << reach.numNodes() << " IK queries..." << endl;
+                int numWorkers = rf.check("reachWorkers",Value(4)).asInt();
+                if (!buildReachability(numWorkers > 0 ? numWorkers : 1))
+                {
+                    printf("Error: Could not build the reachability grid!\n");
+                    return false;
+                }
+                if (reach.save(reachPath))
+                    cout << "Reachability grid saved to " << reachPath << endl;
+                else
+                    cout << "Warning: Could not save the reachability grid to " << reachPath << endl;
+            }
 
-        if ( isOk == 0 )        // Abort!
+            cout << "Reachable cells: " << reach.numReachable() << " (" << 100.0 * reach.fraction() << "% of the box)" << endl;
+            if (reach.numReachable() == 0)
+            {
+                printf("Error: No reachable cell in the box!\n");
+                return false;
+            }
+        }
+        else
         {
-            printf("Error: At least one box vertex is not reachables!\n");
-            return false;
-        }     
+            // Check reachability for each vertex
+            Vector xdhat, odhat, qdhat;     // Response vectors
+            for ( int i = 0 ; i < 8 && isOk ; ++i )
+            {
+                isOk = icart->askForPosition(boxVertexes[i],xdhat,odhat,qdhat) &&
+                       norm(boxVertexes[i] - xdhat) <= reachTolerance;
+                if (!isOk)
+                    cout << "Vertex #" << i+1 << " not reachable" << endl;
+            }
+
+            if ( isOk == 0 )        // Abort!
+            {
+                printf("Error: At least one box vertex is not reachables!\n");
+                return false;
+            }
+        }
         
+        // Active exploration, on the configurations of the reachability grid
+        explore = rf.check("explore",Value(0)).asInt() != 0;
+        if (explore)
+        {
+            exploreCandidates = rf.check("exploreCandidates",Value(32)).asInt();
+            explorePathPoints = rf.check("explorePathPoints",Value(3)).asInt();
+            exploreTimeout = rf.check("exploreTimeout",Value(0.1)).asDouble();
+            Bottle joints = rf.findGroup("exploreJoints").tail();
+            for (int i = 0 ; i < joints.size() ; ++i)
+                exploreJoints.push_back(joints.get(i).asInt());
+            if (exploreJoints.empty())
+                for (int i = 3 ; i < 7 ; ++i)   // Shoulder and elbow after the 3 torso joints
+                    exploreJoints.push_back(i);
+
+            if (!useReach || exploreCandidates < 1 || explorePathPoints < 1 || exploreTimeout <= 0.0)
+            {
+                printf("Error: explore requires reachCells > 0 and positive exploreCandidates, explorePathPoints and exploreTimeout!\n");
+                return false;
+            }
+            candidateSampler.configure("uniform", boxCenterPos, boxSideSizes, 1, 1);
+        }
+
         // Get desired home position of the other arm NOTE: TBI
         
         // Check for potential collisions NOTE: TBI
@@ -332,18 +779,38 @@ public:
         cout << "Configuration parameters:" << endl << endl;
         cout << "robot = " << robot << endl;
         cout << "armSide = " << armSide << endl;
+        cout << "sampler = " << sampler.getType() << endl;
+        cout << "duration = [ " << minDuration << " , " << maxDuration << " ] s" << endl;
+        cout << "blendProgress = " << blendProgress << ", pollPeriod = " << pollPeriod << " s" << endl;
+        if (explore)
+            cout << "explore = " << exploreCandidates << " candidates, " << explorePathPoints << " states per path, timeout "
+                 << exploreTimeout << " s" << endl;
         cout << "-------------------------" << endl << endl;
 
         string fwslash="/";
         // Open ports
         rpcPort.open((fwslash+name+"/rpc:i").c_str());
         printf("rpcPort opened\n");
+        if (explore)
+        {
+            // Set before the connections are made
+            normRpc.setTimeout((float)exploreTimeout);
+            mapRpc.setTimeout((float)exploreTimeout);
+            estRpc.setTimeout((float)exploreTimeout);
+            normRpc.open((fwslash+name+"/norm:rpc").c_str());
+            mapRpc.open((fwslash+name+"/map:rpc").c_str());
+            estRpc.open((fwslash+name+"/est:rpc").c_str());
+        }
 
         // Attach rpcPort to the respond() method
         attach(rpcPort);
 
         printf("rpcPort attached to respond()\n");
 
+        // First target
+        prepareNextTarget();
+        atomicSet(startTime, Time::now());
+
         return true;
     }
 
@@ -356,6 +823,9 @@ public:
         // Close ports
         rpcPort.close();
         printf("rpcPort port closed\n");
+        normRpc.close();
+        mapRpc.close();
+        estRpc.close();
 
         return true;
     }
@@ -363,8 +833,8 @@ public:
     /************************************************************************/
     double getPeriod()
     {
-        // Period in seconds
-        return 0.0;
+        // Period in seconds: motion progress polling
+        return pollPeriod;
     }
 
     /************************************************************************/
@@ -375,9 +845,17 @@ public:
     /************************************************************************/
     bool updateModule()
     {
-        if (verbose) cout << "updateModule() called" << endl;
+        if (atomicGet(paused))
+        {
+            if (moving)
+            {
+                icart->stopControl();
+                moving = false;
+            }
+            return true;
+        }
 
-        handToCenter();
+        scheduleMotions();
         
         return true;
     }
@@ -388,6 +866,9 @@ public:
         // Interrupt any blocking reads on the rpc port        
         rpcPort.interrupt();
         printf("rpcPort interrupted\n");
+        normRpc.interrupt();
+        mapRpc.interrupt();
+        estRpc.interrupt();
 
         return true;
     }
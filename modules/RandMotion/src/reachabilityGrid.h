@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _REACHABILITY_GRID
+#define _REACHABILITY_GRID
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cmath>
+
+#include <yarp/sig/Vector.h>
+#include <yarp/math/Rand.h>
+
+#define REACHABILITY_GRID_VERSION 2
+
+/************************************************************************/
+// Reachability of the workspace box, sampled on the nodes of a regular
+// lattice of cellsPerSide cells per side. The reachability of the nodes is
+// set from the inverse kinematics, then a cell is reachable if all its 8
+// corners are, so that the targets drawn inside it need no further check.
+// The IK joint configurations of the nodes are kept as well, to estimate
+// the configuration of a target by interpolation.
+// The grid is saved to a text file together with the box, robot and arm it
+// was built for, and is only loaded back for the same setup.
+class reachabilityGrid
+{
+private:
+    yarp::sig::Vector   lower;
+    yarp::sig::Vector   sizes;
+    int                 cellsPerSide;
+    double              tolerance;      // Maximum IK position error of a reachable node [m]
+    std::string         setup;          // Robot and arm
+    std::vector<char>   nodes;          // (cellsPerSide + 1)^3, x fastest
+    std::vector<yarp::sig::Vector> nodeConfigs; // IK joint configurations of the nodes
+    std::vector<char>   cells;          // cellsPerSide^3, x fastest
+    std::vector<int>    reachableCells;
+
+    int nodeIndex(int i, int j, int k) const
+    {
+        int n = cellsPerSide + 1;
+        return (k * n + j) * n + i;
+    }
+
+    // Cell containing xd, -1 if outside the box
+    int cellOf(const yarp::sig::Vector &xd) const
+    {
+        int idx = 0;
+        for (int d = 2 ; d >= 0 ; --d)
+        {
+            double s = sizes[d] > 0.0 ? (xd[d] - lower[d]) / sizes[d] : 0.0;
+            if (s < 0.0 || s > 1.0)
+                return -1;
+            int c = (int)(s * cellsPerSide);
+            if (c == cellsPerSide)
+                c = cellsPerSide - 1;
+            idx = idx * cellsPerSide + c;
+        }
+        return idx;
+    }
+
+public:
+    reachabilityGrid() : cellsPerSide(0), tolerance(0.0)
+    {
+    }
+
+    void configure(const yarp::sig::Vector &boxCenter, const yarp::sig::Vector &boxSideSizes, int cells,
+                   double maxError, const std::string &robotArm)
+    {
+        sizes = boxSideSizes;
+        lower.resize(3);
+        for (int d = 0 ; d < 3 ; ++d)
+            lower[d] = boxCenter[d] - 0.5 * boxSideSizes[d];
+        cellsPerSide = cells;
+        tolerance = maxError;
+        setup = robotArm;
+        int n = cellsPerSide + 1;
+        nodes.assign(n * n * n, 0);
+        nodeConfigs.assign(n * n * n, yarp::sig::Vector());
+        this->cells.assign(cellsPerSide * cellsPerSide * cellsPerSide, 0);
+        reachableCells.clear();
+    }
+
+    int numNodes() const
+    {
+        return (int)nodes.size();
+    }
+
+    double getTolerance() const
+    {
+        return tolerance;
+    }
+
+    // Position of a node of the lattice
+    void node(int idx, yarp::sig::Vector &x) const
+    {
+        int n = cellsPerSide + 1;
+        int ijk[3] = { idx % n, (idx / n) % n, idx / (n * n) };
+        x.resize(3);
+        for (int d = 0 ; d < 3 ; ++d)
+            x[d] = lower[d] + sizes[d] * ijk[d] / cellsPerSide;
+    }
+
+    // Called concurrently on distinct nodes while the grid is built
+    void setNode(int idx, bool reachable, const yarp::sig::Vector &q)
+    {
+        nodes[idx] = reachable ? 1 : 0;
+        nodeConfigs[idx] = q;
+    }
+
+    // Cells from the nodes, to be called once all the nodes are set
+    void update()
+    {
+        reachableCells.clear();
+        for (int k = 0 ; k < cellsPerSide ; ++k)
+            for (int j = 0 ; j < cellsPerSide ; ++j)
+                for (int i = 0 ; i < cellsPerSide ; ++i)
+                {
+                    bool ok = true;
+                    for (int c = 0 ; c < 8 && ok ; ++c)
+                        ok = nodes[nodeIndex(i + (c & 1), j + ((c >> 1) & 1), k + ((c >> 2) & 1))] != 0;
+                    int idx = (k * cellsPerSide + j) * cellsPerSide + i;
+                    cells[idx] = ok ? 1 : 0;
+                    if (ok)
+                        reachableCells.push_back(idx);
+                }
+    }
+
+    bool reachable(const yarp::sig::Vector &xd) const
+    {
+        int idx = cellOf(xd);
+        return idx >= 0 && cells[idx] != 0;
+    }
+
+    int numReachable() const
+    {
+        return (int)reachableCells.size();
+    }
+
+    double fraction() const
+    {
+        return cells.empty() ? 0.0 : (double)reachableCells.size() / cells.size();
+    }
+
+    // Joint configuration at xd, trilinear interpolation of the IK solutions
+    // at the corners of its cell. False if xd is not in a reachable cell.
+    bool configuration(const yarp::sig::Vector &xd, yarp::sig::Vector &q) const
+    {
+        int idx = cellOf(xd);
+        if (idx < 0 || cells[idx] == 0)
+            return false;
+
+        int ijk[3] = { idx % cellsPerSide, (idx / cellsPerSide) % cellsPerSide, idx / (cellsPerSide * cellsPerSide) };
+        double frac[3];
+        for (int d = 0 ; d < 3 ; ++d)
+            frac[d] = sizes[d] > 0.0 ? (xd[d] - lower[d]) / sizes[d] * cellsPerSide - ijk[d] : 0.0;
+
+        int n = (int)nodeConfigs[nodeIndex(ijk[0], ijk[1], ijk[2])].size();
+        q.resize(n);
+        for (int j = 0 ; j < n ; ++j)
+            q[j] = 0.0;
+        for (int c = 0 ; c < 8 ; ++c)
+        {
+            int b[3] = { c & 1, (c >> 1) & 1, (c >> 2) & 1 };
+            double w = 1.0;
+            for (int d = 0 ; d < 3 ; ++d)
+                w *= b[d] ? frac[d] : 1.0 - frac[d];
+            const yarp::sig::Vector &qc = nodeConfigs[nodeIndex(ijk[0] + b[0], ijk[1] + b[1], ijk[2] + b[2])];
+            for (int j = 0 ; j < n && j < (int)qc.size() ; ++j)
+                q[j] += w * qc[j];
+        }
+        return true;
+    }
+
+    // Uniform target inside a random reachable cell
+    void randomReachable(yarp::sig::Vector &xd) const
+    {
+        int r = (int)(yarp::math::Rand::scalar(0.0, 1.0) * reachableCells.size());
+        if (r >= (int)reachableCells.size())
+            r = (int)reachableCells.size() - 1;
+        int idx = reachableCells[r];
+        int ijk[3] = { idx % cellsPerSide, (idx / cellsPerSide) % cellsPerSide, idx / (cellsPerSide * cellsPerSide) };
+        xd.resize(3);
+        for (int d = 0 ; d < 3 ; ++d)
+            xd[d] = lower[d] + sizes[d] * (ijk[d] + yarp::math::Rand::scalar(0.0, 1.0)) / cellsPerSide;
+    }
+
+    /************************************************************************/
+    // File format: a header line, the setup, box and lattice parameters,
+    // one character per node ('1' reachable, '0' not), then one line per
+    // node with the size and values of its joint configuration
+    bool save(const std::string &path) const
+    {
+        std::ofstream out(path.c_str());
+        if (!out.is_open())
+            return false;
+        out.precision(10);
+        out << "iRRLSreach " << REACHABILITY_GRID_VERSION << "\n";
+        out << setup << "\n";
+        for (int d = 0 ; d < 3 ; ++d)
+            out << lower[d] << " " << sizes[d] << "\n";
+        out << cellsPerSide << " " << tolerance << "\n";
+        for (size_t i = 0 ; i < nodes.size() ; ++i)
+            out << (nodes[i] ? '1' : '0');
+        out << "\n";
+        for (size_t i = 0 ; i < nodeConfigs.size() ; ++i)
+        {
+            out << nodeConfigs[i].size();
+            for (size_t j = 0 ; j < nodeConfigs[i].size() ; ++j)
+                out << " " << nodeConfigs[i][j];
+            out << "\n";
+        }
+        return out.good();
+    }
+
+    // Loads the nodes only if the file was built for the configured grid
+    bool load(const std::string &path)
+    {
+        std::ifstream in(path.c_str());
+        if (!in.is_open())
+            return false;
+
+        std::string magic, fileSetup, bits;
+        int version = 0, fileCells = 0;
+        double fileTolerance = 0.0;
+        in >> magic >> version;
+        in.ignore(1);
+        std::getline(in, fileSetup);
+        if (magic != "iRRLSreach" || version != REACHABILITY_GRID_VERSION || fileSetup != setup)
+            return false;
+        for (int d = 0 ; d < 3 ; ++d)
+        {
+            double l = 0.0, s = 0.0;
+            in >> l >> s;
+            if (fabs(l - lower[d]) > 1e-6 || fabs(s - sizes[d]) > 1e-6)
+                return false;
+        }
+        in >> fileCells >> fileTolerance >> bits;
+        if (!in || fileCells != cellsPerSide || fabs(fileTolerance - tolerance) > 1e-9 || bits.size() != nodes.size())
+            return false;
+
+        for (size_t i = 0 ; i < nodes.size() ; ++i)
+        {
+            int n = 0;
+            in >> n;
+            if (!in || n < 0)
+                return false;
+            nodeConfigs[i].resize(n);
+            for (int j = 0 ; j < n ; ++j)
+                in >> nodeConfigs[i][j];
+            nodes[i] = bits[i] == '1' ? 1 : 0;
+        }
+        if (!in)
+            return false;
+        update();
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _TARGET_SAMPLER
+#define _TARGET_SAMPLER
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <yarp/sig/Vector.h>
+#include <yarp/math/Rand.h>
+
+#include "reachabilityGrid.h"
+#include "lockFree.h"
+
+// Draws of the sequence per target before falling back to a random reachable cell
+#define MAX_REJECTED_TARGETS 1000
+
+/************************************************************************/
+// Generators of target positions inside the workspace box, centered in
+// center and with the given half sizes. Besides uniform random targets,
+// which cluster and leave gaps, space-filling sequences are available:
+//  sobol    - Sobol low discrepancy sequence, with a random digital shift
+//  lhs      - Latin hypercube batches of lhsBatch targets: each axis is
+//             split in lhsBatch strata, each hit once per batch
+//  farthest - Best of farthestCandidates uniform candidates, the one
+//             farthest from the targets already visited (maximin)
+// The targets are first generated in the unit cube, then scaled to the box.
+// If a reachability grid is given, the targets outside its reachable cells
+// are skipped, so that the sequences are restricted to the reachable space.
+class targetSampler
+{
+private:
+    std::string                 type;
+    yarp::sig::Vector           center;
+    yarp::sig::Vector           halfSizes;
+
+    // sobol
+    unsigned int                sobolV[3][32];  // Direction numbers
+    unsigned int                sobolX[3];
+    unsigned int                sobolShift[3];
+    unsigned int                sobolIndex;
+
+    // lhs
+    int                         lhsBatch;
+    std::vector<int>            lhsPerm[3];
+    int                         lhsNext;
+
+    // farthest
+    int                         candidates;
+    std::vector<yarp::sig::Vector> visited;     // In the unit cube
+
+    static unsigned int randomBits()
+    {
+        return (unsigned int)(yarp::math::Rand::scalar(0.0, 1.0) * 4294967295.0);
+    }
+
+    static int randomInt(int n)
+    {
+        int i = (int)(yarp::math::Rand::scalar(0.0, 1.0) * n);
+        return i < n ? i : n - 1;
+    }
+
+    void initSobol()
+    {
+        // Primitive polynomials and initial direction numbers of the first
+        // three dimensions (Joe and Kuo): x, x + 1, x^2 + x + 1
+        for (int k = 0 ; k < 32 ; ++k)
+            sobolV[0][k] = 1u << (31 - k);
+
+        sobolV[1][0] = 1u << 31;
+        for (int k = 1 ; k < 32 ; ++k)
+            sobolV[1][k] = sobolV[1][k - 1] ^ (sobolV[1][k - 1] >> 1);
+
+        sobolV[2][0] = 1u << 31;
+        sobolV[2][1] = 3u << 30;
+        for (int k = 2 ; k < 32 ; ++k)
+            sobolV[2][k] = sobolV[2][k - 2] ^ (sobolV[2][k - 2] >> 2) ^ sobolV[2][k - 1];
+
+        for (int d = 0 ; d < 3 ; ++d)
+        {
+            sobolX[d] = 0;
+            sobolShift[d] = randomBits();
+        }
+        sobolIndex = 0;
+    }
+
+    void nextSobol(double *u)
+    {
+        // Gray code order: flip the direction number of the lowest zero bit of the index
+        int c = 0;
+        for (unsigned int i = sobolIndex ; i & 1 ; i >>= 1)
+            ++c;
+        ++sobolIndex;
+        for (int d = 0 ; d < 3 ; ++d)
+        {
+            sobolX[d] ^= sobolV[d][c];
+            u[d] = (double)(sobolX[d] ^ sobolShift[d]) / 4294967296.0;
+        }
+    }
+
+    void nextLHS(double *u)
+    {
+        if (lhsNext == 0)
+        {
+            // New batch: a random permutation of the strata per axis
+            for (int d = 0 ; d < 3 ; ++d)
+            {
+                lhsPerm[d].resize(lhsBatch);
+                for (int i = 0 ; i < lhsBatch ; ++i)
+                    lhsPerm[d][i] = i;
+                for (int i = lhsBatch - 1 ; i > 0 ; --i)
+                    std::swap(lhsPerm[d][i], lhsPerm[d][randomInt(i + 1)]);
+            }
+        }
+        for (int d = 0 ; d < 3 ; ++d)
+            u[d] = (lhsPerm[d][lhsNext] + yarp::math::Rand::scalar(0.0, 1.0)) / lhsBatch;
+        lhsNext = (lhsNext + 1) % lhsBatch;
+    }
+
+    double minDistance2(const double *u) const
+    {
+        double best = 1e30;
+        for (size_t i = 0 ; i < visited.size() ; ++i)
+        {
+            double dist = 0.0;
+            for (int d = 0 ; d < 3 ; ++d)
+                dist += (u[d] - visited[i][d]) * (u[d] - visited[i][d]);
+            if (dist < best)
+                best = dist;
+        }
+        return best;
+    }
+
+    // False if no candidate is reachable
+    bool nextFarthest(double *u, const reachabilityGrid *mask)
+    {
+        double best = -1.0;
+        double c[3];
+        yarp::sig::Vector xc;
+        for (int k = 0 ; k < candidates ; ++k)
+        {
+            for (int d = 0 ; d < 3 ; ++d)
+                c[d] = yarp::math::Rand::scalar(0.0, 1.0);
+            if (mask != 0)
+            {
+                toBox(c, xc);
+                if (!mask->reachable(xc))
+                    continue;
+            }
+            double dist = minDistance2(c);
+            if (dist > best)
+            {
+                best = dist;
+                for (int d = 0 ; d < 3 ; ++d)
+                    u[d] = c[d];
+            }
+        }
+        return best >= 0.0;
+    }
+
+public:
+    targetSampler() : sobolIndex(0), lhsBatch(16), lhsNext(0), candidates(50)
+    {
+    }
+
+    // Accepted types: uniform, sobol, lhs, farthest
+    bool configure(const std::string &samplerType, const yarp::sig::Vector &boxCenter, const yarp::sig::Vector &boxSideSizes,
+                   int batch, int numCandidates)
+    {
+        if (samplerType != "uniform" && samplerType != "sobol" && samplerType != "lhs" && samplerType != "farthest")
+            return false;
+        if (batch < 1 || numCandidates < 1)
+            return false;
+
+        type = samplerType;
+        center = boxCenter;
+        halfSizes.resize(3);
+        for (int d = 0 ; d < 3 ; ++d)
+            halfSizes[d] = 0.5 * boxSideSizes[d];
+        lhsBatch = batch;
+        lhsNext = 0;
+        candidates = numCandidates;
+        visited.clear();
+        initSobol();
+        return true;
+    }
+
+    const std::string &getType() const
+    {
+        return type;
+    }
+
+    // Point of the unit cube mapped to the box
+    void toBox(const double *u, yarp::sig::Vector &xd) const
+    {
+        xd.resize(3);
+        for (int d = 0 ; d < 3 ; ++d)
+            xd[d] = center[d] + (2.0 * u[d] - 1.0) * halfSizes[d];
+    }
+
+    // Next target in the unit cube, false if farthest found no reachable candidate
+    bool nextUnit(double *u, const reachabilityGrid *mask = 0)
+    {
+        if (type == "sobol")
+            nextSobol(u);
+        else if (type == "lhs")
+            nextLHS(u);
+        else if (type == "farthest")
+        {
+            if (!nextFarthest(u, mask))
+                return false;
+        }
+        else
+            for (int d = 0 ; d < 3 ; ++d)
+                u[d] = yarp::math::Rand::scalar(0.0, 1.0);
+
+        if (type == "farthest")
+            visited.push_back(yarp::sig::Vector(3, u));
+        return true;
+    }
+
+    // Next target in the box, inside the reachable cells of mask if given
+    void next(yarp::sig::Vector &xd, const reachabilityGrid *mask = 0)
+    {
+        double u[3];
+        for (int k = 0 ; k < MAX_REJECTED_TARGETS ; ++k)
+        {
+            if (nextUnit(u, mask))
+            {
+                toBox(u, xd);
+                if (mask == 0 || mask->reachable(xd))
+                    return;
+            }
+        }
+
+        // Sparse reachable space: skip the sequence
+        mask->randomReachable(xd);
+    }
+};
+
+/************************************************************************/
+// Fraction of the cells of a grid over the box visited by the targets, as a
+// measure of how evenly the workspace has been explored
+class coverageGrid
+{
+private:
+    yarp::sig::Vector   lower;
+    yarp::sig::Vector   sizes;
+    int                 cellsPerSide;
+    std::vector<bool>   hit;
+    int                 numHit;
+
+public:
+    coverageGrid() : cellsPerSide(1), numHit(0)
+    {
+    }
+
+    void configure(const yarp::sig::Vector &boxCenter, const yarp::sig::Vector &boxSideSizes, int cells)
+    {
+        sizes = boxSideSizes;
+        lower.resize(3);
+        for (int d = 0 ; d < 3 ; ++d)
+            lower[d] = boxCenter[d] - 0.5 * boxSideSizes[d];
+        cellsPerSide = cells > 0 ? cells : 1;
+        hit.assign(cellsPerSide * cellsPerSide * cellsPerSide, false);
+        numHit = 0;
+    }
+
+    void add(const yarp::sig::Vector &xd)
+    {
+        int idx = 0;
+        for (int d = 2 ; d >= 0 ; --d)
+        {
+            int c = sizes[d] > 0.0 ? (int)((xd[d] - lower[d]) / sizes[d] * cellsPerSide) : 0;
+            c = std::max(0, std::min(cellsPerSide - 1, c));
+            idx = idx * cellsPerSide + c;
+        }
+        if (!hit[idx])
+        {
+            hit[idx] = true;
+            atomicSet(numHit, numHit + 1);
+        }
+    }
+
+    // Safe to call while another thread adds targets
+    double coverage() const
+    {
+        return hit.empty() ? 0.0 : (double)atomicGet(numHit) / hit.size();
+    }
+};
+
+#endif
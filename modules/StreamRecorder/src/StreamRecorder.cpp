@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+// Records the vectors received on vec:i (e.g. from Synchronizer/vec:o), with
+// their envelope timestamps and arrival times, to a binary log which can be
+// played back by StreamReplayer. The port reads in strict mode, so that no
+// message is dropped while the log is written.
+
+#include <iostream>
+#include <string>
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Vocab.h>
+
+#include "wireVector.h"
+#include "streamLog.h"
+
+using namespace std;
+using namespace yarp::os;
+
+/************************************************************************/
+class StreamRecorder: public RFModule
+{
+protected:
+
+    // Ports
+    BufferedPort<wireVector>  inPort;
+    Port                      rpcPort;
+
+    streamLogWriter log;
+    string          logPath;        // Base name of the log files
+    double          flushPeriod;    // [s]
+    double          lastFlush;
+    double          startTime;
+    int             lastSize;
+
+public:
+    /************************************************************************/
+    StreamRecorder() : flushPeriod(1.0), lastFlush(0.0), startTime(0.0), lastSize(-1)
+    {
+    }
+
+    // rpcPort commands handler
+    bool respond(const Bottle &      command,
+                 Bottle &      reply)
+    {
+        string receivedCmd = command.get(0).asString().c_str();
+        reply.clear();
+
+        if (receivedCmd == "help")
+        {
+            reply.addVocab(Vocab::encode("many"));
+            reply.addString("Available commands are:");
+            reply.addString("help");
+            reply.addString("stats");
+            reply.addString("quit");
+        }
+        else if (receivedCmd == "stats")
+        {
+            // Counters updated by updateModule, read atomically
+            reply.addString("records");
+            reply.addInt((int)log.count());
+            reply.addString("bytes");
+            reply.addDouble((double)log.bytes());
+            reply.addString("pending");
+            reply.addInt(inPort.getPendingReads());
+            reply.addString("file");
+            reply.addString((logPath + ".log").c_str());
+        }
+        else if (receivedCmd == "quit")
+        {
+            reply.addString("Quitting.");
+            return false;
+        }
+        else
+            reply.addString("Invalid command, type [help] for a list of accepted commands.");
+
+        return true;
+    }
+
+    bool configure(ResourceFinder &rf)
+    {
+        string name=rf.find("name").asString().c_str();
+        setName(name.c_str());
+
+        // Log files, in the context directory of the user unless an absolute path is given
+        string logName = rf.check("logName",Value("stream")).asString().c_str();
+        logPath = logName[0] == '/' ? logName : string(rf.getHomeContextPath().c_str()) + "/" + logName;
+        bool append = rf.check("append",Value(0)).asInt() != 0;
+        flushPeriod = rf.check("flushPeriod",Value(1.0)).asDouble();
+
+        if (!log.open(logPath, append))
+            return false;
+
+        cout << endl << "-------------------------" << endl;
+        cout << "Recording to " << logPath << ".log" << (append ? " (append)" : "") << endl;
+        cout << "flushPeriod = " << flushPeriod << " s" << endl;
+        cout << "-------------------------" << endl << endl;
+
+        // Open ports. Strict reading: messages are queued while the log is written
+        string fwslash="/";
+        inPort.setStrict();
+        inPort.open((fwslash+name+"/vec:i").c_str());
+        rpcPort.open((fwslash+name+"/rpc:i").c_str());
+
+        // Attach rpcPort to the respond() method
+        attach(rpcPort);
+
+        startTime = Time::now();
+        lastFlush = startTime;
+        return true;
+    }
+
+    /************************************************************************/
+    bool close()
+    {
+        inPort.close();
+        rpcPort.close();
+
+        double elapsed = Time::now() - startTime;
+        cout << "Recorded " << log.count() << " vectors in " << elapsed << " s to " << logPath << ".log" << endl;
+        log.close();
+
+        return true;
+    }
+
+    /************************************************************************/
+    double getPeriod()
+    {
+        return 0.0;
+    }
+
+    /************************************************************************/
+    bool updateModule()
+    {
+        wireVector *bin = inPort.read();    // blocking call
+        if (bin == 0)
+            return true;
+
+        double arrival = Time::now();
+        Stamp info;
+        inPort.getEnvelope(info);
+        double stamp = info.isValid() ? info.getTime() : arrival;
+
+        if (bin->size() != lastSize)
+        {
+            if (lastSize >= 0)
+                cout << "Warning: vector size changed from " << lastSize << " to " << bin->size() << endl;
+            lastSize = bin->size();
+        }
+
+        if (!log.write(stamp, arrival, bin->data.data(), bin->size()))
+        {
+            printf("Error: Could not write to %s.log!\n", logPath.c_str());
+            return false;
+        }
+
+        if (arrival - lastFlush > flushPeriod)
+        {
+            log.flush();
+            lastFlush = arrival;
+        }
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool interruptModule()
+    {
+        inPort.interrupt();
+        rpcPort.interrupt();
+        return true;
+    }
+};
+
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    Network yarp;
+    if (!yarp.checkNetwork())
+    {
+        printf("YARP server not available!\n");
+        return -1;
+    }
+
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultConfigFile("StreamRecorder_config.ini");
+    rf.setDefaultContext("iRRLS");
+    rf.setDefault("name","StreamRecorder");
+    rf.configure(argc,argv);
+
+    StreamRecorder mod;
+    return mod.runModule(rf);
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+// Plays back on vec:o a log written by StreamRecorder, so that the pipeline can
+// be run and benchmarked without the robot. The vectors are sent with the
+// timing at which they were recorded (speed 1), N times faster (speed N) or as
+// fast as the consumers accept them (speed 0), with their original envelope
+// timestamps unless restamp is set. The module quits at the end of the log,
+// unless loop is set, printing the achieved rate.
+
+#include <iostream>
+#include <string>
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Vocab.h>
+
+#include "wireVector.h"
+#include "streamLog.h"
+#include "lockFree.h"
+
+using namespace std;
+using namespace yarp::os;
+
+/************************************************************************/
+class StreamReplayer: public RFModule
+{
+protected:
+
+    // Ports
+    BufferedPort<wireVector>  outPort;
+    Port                      rpcPort;
+
+    streamLogReader log;
+    string          logPath;
+    double          speed;          // Playback speed, 0 for as fast as possible
+    bool            loop;
+    bool            restamp;        // Stamp the vectors with the playback time
+    int             first;          // Replayed records
+    int             last;
+
+    double          playStart;      // Playback time of the first record of the pass
+    double          logStart;       // Arrival time of the first record of the pass
+    double          stamp, arrival;
+    Stamp           outStamp;
+    long unsigned int sent;
+    double          maxLate;        // Maximum delay of a record on its schedule [s]
+    double          startTime;
+
+    /************************************************************************/
+    void rewind()
+    {
+        log.seek(first);
+        logStart = log.arrival(first);
+        playStart = Time::now();
+    }
+
+public:
+    /************************************************************************/
+    StreamReplayer() : speed(1.0), loop(false), restamp(false), first(0), last(0),
+                       playStart(0.0), logStart(0.0), stamp(0.0), arrival(0.0),
+                       sent(0), maxLate(0.0), startTime(0.0)
+    {
+    }
+
+    // rpcPort commands handler
+    bool respond(const Bottle &      command,
+                 Bottle &      reply)
+    {
+        string receivedCmd = command.get(0).asString().c_str();
+        reply.clear();
+
+        if (receivedCmd == "help")
+        {
+            reply.addVocab(Vocab::encode("many"));
+            reply.addString("Available commands are:");
+            reply.addString("help");
+            reply.addString("stats");
+            reply.addString("quit");
+        }
+        else if (receivedCmd == "stats")
+        {
+            // Counters updated by updateModule, read atomically
+            long unsigned int n = atomicGet(sent);
+            double elapsed = Time::now() - startTime;
+            reply.addString("sent");
+            reply.addInt((int)n);
+            reply.addString("position");
+            reply.addInt(log.tell());
+            reply.addString("rate");
+            reply.addDouble(elapsed > 0.0 ? n / elapsed : 0.0);
+            reply.addString("maxLate");
+            reply.addDouble(atomicGet(maxLate));
+        }
+        else if (receivedCmd == "quit")
+        {
+            reply.addString("Quitting.");
+            return false;
+        }
+        else
+            reply.addString("Invalid command, type [help] for a list of accepted commands.");
+
+        return true;
+    }
+
+    bool configure(ResourceFinder &rf)
+    {
+        string name=rf.find("name").asString().c_str();
+        setName(name.c_str());
+
+        // Log files, looked up in the context unless an absolute path is given
+        string logName = rf.check("logName",Value("stream")).asString().c_str();
+        if (logName[0] == '/')
+            logPath = logName;
+        else
+        {
+            string found = rf.findFile((logName + ".log").c_str()).c_str();
+            logPath = found != "" ? found.substr(0, found.size() - 4) : logName;
+        }
+
+        speed = rf.check("speed",Value(1.0)).asDouble();
+        loop = rf.check("loop",Value(0)).asInt() != 0;
+        restamp = rf.check("restamp",Value(0)).asInt() != 0;
+        double start = rf.check("start",Value(0.0)).asDouble();
+        double duration = rf.check("duration",Value(-1.0)).asDouble();
+
+        if (speed < 0.0)
+        {
+            printf("Error: speed must be positive, or 0 for as fast as possible!\n");
+            return false;
+        }
+
+        if (!log.open(logPath))
+            return false;
+        if (log.size() == 0)
+        {
+            printf("Error: %s.log is empty!\n", logPath.c_str());
+            return false;
+        }
+
+        // Records to replay, from the index
+        double t0 = log.arrival(0);
+        first = log.find(t0 + start);
+        last = duration >= 0.0 ? log.find(t0 + start + duration) : log.size();
+        if (first >= last)
+        {
+            printf("Error: No records between %g s and %g s!\n", start, start + duration);
+            return false;
+        }
+
+        cout << endl << "-------------------------" << endl;
+        cout << "Replaying " << logPath << ".log" << endl;
+        cout << "Records " << first << " to " << last - 1 << " of " << log.size()
+             << ", " << log.arrival(last - 1) - log.arrival(first) << " s" << endl;
+        if (speed > 0.0)
+            cout << "speed = " << speed << "x" << endl;
+        else
+            cout << "speed = as fast as possible" << endl;
+        cout << "loop = " << loop << ", restamp = " << restamp << endl;
+        cout << "-------------------------" << endl << endl;
+
+        // Open ports
+        string fwslash="/";
+        outPort.open((fwslash+name+"/vec:o").c_str());
+        rpcPort.open((fwslash+name+"/rpc:i").c_str());
+
+        // Attach rpcPort to the respond() method
+        attach(rpcPort);
+
+        startTime = Time::now();
+        rewind();
+        return true;
+    }
+
+    /************************************************************************/
+    bool close()
+    {
+        outPort.close();
+        rpcPort.close();
+
+        double elapsed = Time::now() - startTime;
+        cout << "Sent " << sent << " vectors in " << elapsed << " s";
+        if (elapsed > 0.0)
+            cout << " (" << sent / elapsed << " vectors/s)";
+        cout << ", maximum delay on schedule " << 1000.0 * maxLate << " ms" << endl;
+        log.close();
+
+        return true;
+    }
+
+    /************************************************************************/
+    double getPeriod()
+    {
+        return 0.0;
+    }
+
+    /************************************************************************/
+    bool updateModule()
+    {
+        if (log.tell() >= last)
+        {
+            if (!loop)
+            {
+                cout << "End of the log reached" << endl;
+                return false;
+            }
+            rewind();
+        }
+
+        wireVector &bout = outPort.prepare();
+        if (!log.read(stamp, arrival, bout.data))
+        {
+            outPort.unprepare();
+            printf("Error: Could not read record %d of %s.log!\n", log.tell(), logPath.c_str());
+            return false;
+        }
+
+        if (speed > 0.0)
+        {
+            // Wait for the time of the record on the playback schedule
+            double due = playStart + (arrival - logStart) / speed;
+            double wait = due - Time::now();
+            if (wait > 0.0)
+                Time::delay(wait);
+            else if (-wait > maxLate)
+                atomicSet(maxLate, -wait);
+        }
+
+        outStamp.update(restamp ? Time::now() : stamp);
+        outPort.setEnvelope(outStamp);
+
+        // As fast as possible: wait until the previous vector has been sent
+        if (speed > 0.0)
+            outPort.write();
+        else
+            outPort.writeStrict();
+        atomicIncrement(sent);
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool interruptModule()
+    {
+        outPort.interrupt();
+        rpcPort.interrupt();
+        return true;
+    }
+};
+
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    Network yarp;
+    if (!yarp.checkNetwork())
+    {
+        printf("YARP server not available!\n");
+        return -1;
+    }
+
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultConfigFile("StreamReplayer_config.ini");
+    rf.setDefaultContext("iRRLS");
+    rf.setDefault("name","StreamReplayer");
+    rf.configure(argc,argv);
+
+    StreamReplayer mod;
+    return mod.runModule(rf);
+}
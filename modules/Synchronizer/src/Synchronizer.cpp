@@ -17,89 +17,125 @@
  * Public License for more details
 */
 
-// Synchronizes position, velocity, acceleration and force/torque data to form a single Vector for further processing
-// Note: Velocity and acceleration are estimated in the callback of the read function, as soon as a new position sample is received
+// Synchronizes N input streams (e.g. joint positions of several parts and force/torque sensors) to form a single
+// Vector for further processing. The streams and the layout of the output are declared in the configuration:
+//
+//  streams     (right_arm ft)      ; order of the streams in the output vector
+//  clock       ft                  ; stream driving the output
+//  [right_arm]
+//  type        position            ; position: velocity and acceleration are estimated ; raw: values as received
+//  port        /pos:i              ; input port, after the module name
+//  joints      (0 1 2 3)           ; indices of the incoming values to use (default: the first 'size'), only
+//                                  ; these are decoded from the incoming messages
+//  size        4
+//  fields      (q qdot qdotdot)    ; position streams: selected and ordered fields of the output
+//  decimation  1                   ; one sample every 'decimation' received
+//  derivEstimator aw               ; derivative options of the stream, see pvaEstimator
+//
+// Without 'streams', the original layout [ q , qdot , qdotdot , F , T ] is used, with xsz joints on /pos:i and
+// t F/T values on /ft:i driving the output; 'joints' and 'posDecimation' select the position samples.
+// The port callbacks only select and queue the incoming values; derivative estimation, alignment and output run
+// in a single event loop. Each sample of the clock stream is emitted together with the other streams aligned to
+// its timestamp (nearest sample, linear interpolation or last sample), within a maximum skew.
 
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <vector>
+#include <ctime>
 
 #include <yarp/os/Network.h>
 #include <yarp/os/RFModule.h>
 #include <yarp/os/BufferedPort.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Semaphore.h>
 #include <yarp/os/Stamp.h>
 #include <yarp/os/Time.h>
-#include <yarp/os/Mutex.h>
+#include <yarp/os/Vocab.h>
 #include <yarp/sig/Vector.h>
 
-#include <iCub/ctrl/adaptWinPolyEstimator.h>
+#include "pvaEstimator.h"
+#include "timedBuffer.h"
+#include "lockFree.h"
+#include "jointSelector.h"
 
 using namespace std;
 using namespace yarp::os;
 using namespace yarp::sig;
-using namespace iCub::ctrl;
 
-// A class which handles the incoming data.
-// The estimated derivatives are returned at once
-// since they are computed within the onRead method.
-class dataCollector : public BufferedPort<Bottle>
+/************************************************************************/
+// An input stream declared in the configuration
+struct syncStream
 {
-private:
-    AWLinEstimator       *linEst;
-    AWQuadEstimator      *quadEst;
-    
-    Vector* PVABuffer;      // pointer to the Vector which contains q, qdot, qdotdot
-    Mutex* PVABufferMutex;  // pointer to the Mutex that protects the access to internal buffer containing q, qdot, qdotdot
-    
-    
-    virtual void onRead(Bottle &b)
+    string                name;
+    string                port;
+    bool                  position;     // Estimate velocity and acceleration
+    vector<int>           joints;       // Indices of the incoming values
+    vector<int>           fields;       // Position streams: 0 - q, 1 - qdot, 2 - qdotdot
+    int                   decimation;
+    alignPolicy           policy;
+    int                   outOffset;    // First element of the stream in the output
+    int                   outSize;
+
+    pvaEstimator         *estimator;
+    spscTimedQueue        queue;        // Selected values from the port callback
+    timedBuffer           history;      // Timestamped output values of the stream
+    Vector                q, qdot, qdotdot, out;
+    long unsigned int     lost;         // Samples lost on a full queue
+    bool                  periodChecked;    // Sample period compared with maxSkew
+
+    syncStream() : position(false), decimation(1), policy(ALIGN_LINEAR), outOffset(0), outSize(0),
+                   estimator(0), lost(0), periodChecked(false)
     {
-        Stamp info;
-        BufferedPort<Bottle>::getEnvelope(info);
-        
-        size_t xsz = b.size();
-        Vector x(xsz);
+    }
 
-        cout << "Received position bottle: " << b.toString() << endl;
-        
-        for (int i=0; i < b.size(); i++) {
-            x[i] = b.get(i).asDouble();
-            cout << "x[" << i <<"] =" << x[i] <<endl;
+    ~syncStream()
+    {
+        delete estimator;
+    }
+
+    // Fill out with the fields of the stream for the sample queued at time
+    void compute(double time, const Vector &x)
+    {
+        if (!position)
+        {
+            out = x;
+            return;
         }
 
-        // for the estimation the time stamp
-        // is required. If not present within the
-        // packet, the actual machine time is 
-        // attached to it.
-        AWPolyElement el(x,info.isValid()?info.getTime():Time::now());
-        
-        // Protect ON
-        PVABufferMutex->lock();
-        
-        PVABuffer->setSubvector( 0 , x );
-        PVABuffer->setSubvector( xsz , linEst->estimate(el) );
-        PVABuffer->setSubvector( 2*xsz , quadEst->estimate(el) );
-        
-        PVABufferMutex->unlock();
-        // Protect OFF        
+        estimator->estimate(x, time, qdot, qdotdot);
+        int n = (int)x.size();
+        for (size_t f = 0 ; f < fields.size() ; ++f)
+        {
+            const Vector &src = fields[f] == 0 ? x : (fields[f] == 1 ? qdot : qdotdot);
+            for (int i = 0 ; i < n ; ++i)
+                out[f * n + i] = src[i];
+        }
     }
+};
 
-public:
-    dataCollector(unsigned int NVel, double DVel, 
-                  unsigned int NAcc, double DAcc,
-                  Vector* buf,
-                  Mutex* bufMut)
+// A class which handles the incoming data of a stream.
+// Only the selected values are decoded and queued, the processing
+// is left to the event loop of the module.
+class streamCollector : public jointSelector
+{
+private:
+    syncStream           *stream;
+    Semaphore            *dataReady;    // Wakes up the event loop
+    bool                  verbose;
+
+    virtual void onSelected(double time, const Vector &x)
     {
-        linEst  = new AWLinEstimator(NVel,DVel);
-        quadEst = new AWQuadEstimator(NAcc,DAcc);
-        PVABuffer = buf;
-        PVABufferMutex = bufMut;
+        if (verbose) cout << "Received " << stream->name << " sample: " << x.toString() << endl;
+
+        if (!stream->queue.push(time, x.data(), (int)x.size()))
+            atomicIncrement(stream->lost);
+        dataReady->post();
     }
 
-    ~dataCollector()
+public:
+    streamCollector(syncStream *s, Semaphore *sem, bool verb) : stream(s), dataReady(sem), verbose(verb)
     {
-        delete linEst;
-        delete quadEst;
     }
 };
 
@@ -107,149 +143,438 @@ class Synchronizer: public RFModule
 {
 private:
 
-    dataCollector        *port_pos;     // Input Vector [ q ]
-    BufferedPort<Bottle>  FTport;       // Input Force/torque data    [ F , T ]
-    BufferedPort<Vector>  outPort;      // Output vector [ q , qdot, qdotdot, F, T ]
-    Port                  rpcPort;      
-    Vector*               FTVector;
-    size_t                t;            // Size of the F/T vector
-    size_t                xsz;          // Size of the F/T vector
+    vector<syncStream*>       streams;
+    vector<streamCollector*>  ports;
+    int                       clockStream;  // Index of the stream driving the output
+    BufferedPort<Vector>      outPort;      // Output vector, the streams in the configured order
+    Port                      rpcPort;      
+    Semaphore                 dataReady;    // Posted by the port callbacks
+    int                       outSize;
+
+    double                maxSkew;      // Maximum time distance of the aligned samples [s]
+    int                   bufferLength;
+    timedBuffer           clockQueue;   // Samples of the clock stream waiting to be aligned
+    Vector                aligned;      // Aligned values of a stream
+    Stamp                 outStamp;
+    long unsigned int     emitted;      // Number of output samples
+    long unsigned int     dropped;      // Number of clock samples without all the streams within maxSkew
+
+    // Output rate and CPU usage, updated every statsPeriod seconds
+    double                statsPeriod;
+    double                lastStatsTime;
+    clock_t               lastClock;
+    long unsigned int     lastEmitted;
+    double                outRate;      // [samples/s]
+    double                cpuLoad;      // Process CPU time over wall time [%]
+
+    /************************************************************************/
+    // Set up a stream from its configuration group
+    bool addStream(const string &name, const Searchable &cfg, bool verbose)
+    {
+        syncStream *s = new syncStream;
+        streams.push_back(s);
+        s->name = name;
+        s->port = cfg.check("port",Value("/" + name + ":i")).asString().c_str();
+
+        string type = cfg.check("type",Value("raw")).asString().c_str();
+        if (type != "position" && type != "raw")
+        {
+            printf("Error: Stream %s: type must be position or raw!\n", name.c_str());
+            return false;
+        }
+        s->position = type == "position";
+
+        // Selected values
+        Bottle *joints = cfg.find("joints").asList();
+        if (joints != 0)
+        {
+            for (int i = 0 ; i < joints->size() ; ++i)
+                s->joints.push_back(joints->get(i).asInt());
+        }
+        else
+        {
+            int size = cfg.check("size",Value(0)).asInt();
+            for (int i = 0 ; i < size ; ++i)
+                s->joints.push_back(i);
+        }
+        int n = (int)s->joints.size();
+        if (n == 0)
+        {
+            printf("Error: Stream %s: no values selected, set size or joints!\n", name.c_str());
+            return false;
+        }
+
+        // Output fields
+        if (s->position)
+        {
+            Bottle *fields = cfg.find("fields").asList();
+            Bottle defFields("q qdot qdotdot");
+            if (fields == 0)
+                fields = &defFields;
+            for (int f = 0 ; f < fields->size() ; ++f)
+            {
+                string field = fields->get(f).asString().c_str();
+                if (field == "q")
+                    s->fields.push_back(0);
+                else if (field == "qdot")
+                    s->fields.push_back(1);
+                else if (field == "qdotdot")
+                    s->fields.push_back(2);
+                else
+                {
+                    printf("Error: Stream %s: unknown field %s!\n", name.c_str(), field.c_str());
+                    return false;
+                }
+            }
+            s->outSize = n * (int)s->fields.size();
+            s->estimator = new pvaEstimator(cfg);
+        }
+        else
+            s->outSize = n;
+
+        s->decimation = cfg.check("decimation",Value(1)).asInt();
+        if (s->decimation < 1)
+        {
+            cout << "Warning: decimation must be at least 1, setting decimation = 1" << endl;
+            s->decimation = 1;
+        }
+
+        string align = cfg.check("align",Value("linear")).asString().c_str();
+        if (!parseAlignPolicy(align, s->policy))
+        {
+            printf("Error: Stream %s: alignment policy not available! Use nearest, linear or hold.\n", name.c_str());
+            return false;
+        }
+
+        s->out.resize(s->outSize, 0.0);
+        s->queue.resize(bufferLength, n);
+        s->history.resize(bufferLength, s->outSize);
+        s->outOffset = outSize;
+        outSize += s->outSize;
+
+        streamCollector *port = new streamCollector(s, &dataReady, verbose);
+        ports.push_back(port);
+        if (!port->configure(s->joints, s->decimation))
+        {
+            printf("Error: Stream %s: joint indices must not be negative!\n", name.c_str());
+            return false;
+        }
+
+        cout << "Stream " << name << ": " << type << ", " << n << " values, "
+             << s->outSize << " outputs, decimation " << s->decimation << ", align " << align << endl;
+        return true;
+    }
+
+    /************************************************************************/
+    // Move the samples queued by the port callbacks to the stream histories
+    // (estimating the derivatives), and the clock samples to clockQueue
+    void collect()
+    {
+        for (size_t k = 0 ; k < streams.size() ; ++k)
+        {
+            syncStream *s = streams[k];
+            while (!s->queue.empty())
+            {
+                double time = s->queue.frontTime();
+                s->compute(time, s->queue.front());
+                s->queue.pop();
+
+                if ((int)k == clockStream)
+                    clockQueue.push(time, s->out.data(), s->outSize);
+                else
+                    s->history.push(time, s->out.data(), s->outSize);
+            }
+
+            if ((int)k != clockStream && !s->periodChecked)
+                checkPeriod(s);
+        }
+    }
+
+    /************************************************************************/
+    // Once the first samples of a stream have arrived, warn if its sample
+    // period exceeds maxSkew: most of the clock samples would be dropped
+    void checkPeriod(syncStream *s)
+    {
+        const int numSamples = 10;
+        int n = s->history.size();
+        if (n < numSamples)
+            return;
+
+        s->periodChecked = true;
+        double period = (s->history.newestTime() - s->history.timeAt(0)) / (n - 1);
+        if (maxSkew < period)
+            cout << "Warning: Stream " << s->name << " has a sample period of " << period << " s, more than maxSkew = "
+                 << maxSkew << " s: the clock samples far from its samples will be dropped. Raise maxSkew or lower its decimation" << endl;
+    }
+
+    /************************************************************************/
+    // Emit the queued clock samples for which all the streams can be aligned
+    void process()
+    {
+        while (clockQueue.size() > 0)
+        {
+            double tClock = clockQueue.timeAt(0);
+
+            // Stop waiting for newer samples once clock samples more than maxSkew newer have arrived
+            bool force = clockQueue.newestTime() - tClock > maxSkew;
+
+            Vector& out = outPort.prepare();
+            out.resize(outSize);
+
+            int res = ALIGN_OK;
+            for (size_t k = 0 ; k < streams.size() && res == ALIGN_OK ; ++k)
+            {
+                syncStream *s = streams[k];
+                if ((int)k == clockStream)
+                    out.setSubvector( s->outOffset , clockQueue.at(0) );
+                else
+                {
+                    res = s->history.align(tClock, s->policy, maxSkew, force, aligned);
+                    if (res == ALIGN_OK)
+                        out.setSubvector( s->outOffset , aligned );
+                }
+            }
+
+            if (res == ALIGN_WAIT)
+            {
+                outPort.unprepare();
+                break;
+            }
+
+            if (res == ALIGN_OK)
+            {
+                // the outbound packets carry the timestamp of the clock sample
+                outStamp.update(tClock);
+                outPort.setEnvelope(outStamp);
+                outPort.write();
+                atomicIncrement(emitted);
+            }
+            else
+            {
+                outPort.unprepare();
+                atomicIncrement(dropped);
+            }
+
+            clockQueue.popFront();
+        }
+    }
+
+    /************************************************************************/
+    // Update the sustained output rate and the CPU usage of the module
+    void updateStats()
+    {
+        double now = Time::now();
+        double dt = now - lastStatsTime;
+        if (dt < statsPeriod)
+            return;
+
+        clock_t cpuNow = clock();
+        double rate = (emitted - lastEmitted) / dt;
+        double load = 100.0 * (double)(cpuNow - lastClock) / CLOCKS_PER_SEC / dt;
+        atomicSet(outRate, rate);
+        atomicSet(cpuLoad, load);
+        lastStatsTime = now;
+        lastClock = cpuNow;
+        lastEmitted = emitted;
+
+        printf("Output rate: %.1f samples/s, CPU: %.1f%%, dropped: %lu, lost: %lu\n", rate, load, dropped, lostSamples());
+    }
+
+    long unsigned int lostSamples() const
+    {
+        long unsigned int lost = 0;
+        for (size_t k = 0 ; k < streams.size() ; ++k)
+            lost += atomicGet(streams[k]->lost);
+        return lost;
+    }
+
+    long unsigned int decodeErrors() const
+    {
+        long unsigned int errors = 0;
+        for (size_t k = 0 ; k < ports.size() ; ++k)
+            errors += ports[k]->decodeErrors();
+        return errors;
+    }
 
 public:
     
-    Vector PVABuffer;      // Vector which contains q, qdot, qdotdot
-    Mutex PVABufferMutex;  // Mutex that protects the access to internal buffer containing q, qdot, qdotdot
-    
+    Synchronizer() : clockStream(-1), dataReady(0), outSize(0), emitted(0), dropped(0), outRate(0.0), cpuLoad(0.0)
+    {
+    }
+
+    bool respond(const Bottle &command, Bottle &reply)
+    {
+        string receivedCmd = command.get(0).asString().c_str();
+        reply.clear();
+
+        if (receivedCmd == "help")
+        {
+            reply.addVocab(Vocab::encode("many"));
+            reply.addString("Available commands are:");
+            reply.addString("help");
+            reply.addString("stats");
+            reply.addString("quit");
+        }
+        else if (receivedCmd == "stats")
+        {
+            // Counters updated by the event loop and the port callbacks, read atomically
+            reply.addString("emitted");
+            reply.addInt((int)atomicGet(emitted));
+            reply.addString("dropped");
+            reply.addInt((int)atomicGet(dropped));
+            reply.addString("lost");
+            reply.addInt(lostSamples());
+            reply.addString("decodeErrors");
+            reply.addInt(decodeErrors());
+            reply.addString("rate");
+            reply.addDouble(atomicGet(outRate));
+            reply.addString("cpu");
+            reply.addDouble(atomicGet(cpuLoad));
+        }
+        else if (receivedCmd == "quit")
+        {
+            reply.addString("Quitting.");
+            return false;
+        }
+        else
+            reply.addString("Invalid command, type [help] for a list of accepted commands.");
+
+        return true;
+    }
+
     virtual bool configure(ResourceFinder &rf)
     {
         // request high resolution scheduling
         Time::turboBoost();
 
         string portName=rf.check("name",Value("/Synchronizer")).asString().c_str();
+        bool verbose = rf.check("verbose",Value(0)).asInt() != 0;
 
-        unsigned int NVel=rf.check("lenVel",Value(16)).asInt();
-        unsigned int NAcc=rf.check("lenAcc",Value(25)).asInt();
-
-        double DVel=rf.check("thrVel",Value(1.0)).asDouble();
-        double DAcc=rf.check("thrAcc",Value(1.0)).asDouble();
-        
-        t = rf.check("t", Value(6)).asInt();
-        xsz = rf.check("xsz", Value(4)).asInt();
-
-        FTVector = new Vector( t , 0.0 );         // Allocate F/T buffer Vector
-        
-        PVABufferMutex.lock();
-        PVABuffer.clear();
-        PVABuffer.resize(3*xsz + t , 0.0);
-        PVABufferMutex.unlock();
-
-        if (NVel<2)
+        maxSkew = rf.check("maxSkew", Value(0.1)).asDouble();
+        bufferLength = rf.check("bufferLength", Value(100)).asInt();
+        if (maxSkew <= 0.0 || bufferLength < 2)
         {
-            cout<<"Warning: lenVel cannot be lower than 2 => N=2 is assumed"<<endl;
-            NVel=2;
+            printf("Error: maxSkew must be positive and bufferLength at least 2!\n");
+            return false;
         }
 
-        if (NAcc<3)
+        string clockName;
+        Bottle *streamList = rf.find("streams").asList();
+        if (streamList != 0)
         {
-            cout<<"Warning: lenAcc cannot be lower than 3 => N=3 is assumed"<<endl;
-            NAcc=3;
+            // Streams declared in the configuration. Alignment, decimation and
+            // derivative options can be given globally and overridden per stream.
+            // The global joints select the positions of the original layout only.
+            for (int k = 0 ; k < streamList->size() ; ++k)
+            {
+                string name = streamList->get(k).asString().c_str();
+                Property cfg(rf.toString().c_str());
+                cfg.unput("joints");
+                Property group(rf.findGroup(name).toString().c_str());
+                cfg.fromString(group.toString(), false);
+                if (!addStream(name, cfg, verbose))
+                    return false;
+            }
+            clockName = rf.check("clock",streamList->get(streamList->size() - 1)).asString().c_str();
         }
-
-        if (DVel<0.0)
+        else
         {
-            cout<<"Warning: thrVel cannot be lower than 0.0 => D=0.0 is assumed"<<endl;
-            DVel=0.0;
+            // Original layout: [ q , qdot , qdotdot ] of xsz joints, then t F/T values driving the output.
+            // The joints are the first xsz of /pos:i, or those listed in 'joints'.
+            int xsz = rf.check("xsz", Value(4)).asInt();
+            Bottle *joints = rf.find("joints").asList();
+            if (joints != 0 && joints->size() != xsz)
+            {
+                printf("Error: %d joints listed, xsz = %d!\n", joints->size(), xsz);
+                return false;
+            }
+            Property posCfg(rf.toString().c_str());
+            posCfg.put("type", "position");
+            posCfg.put("size", xsz);
+            posCfg.put("port", "/pos:i");
+            posCfg.put("decimation", rf.check("posDecimation", Value(1)).asInt());
+            Property ftCfg;
+            ftCfg.put("type", "raw");
+            ftCfg.put("size", rf.check("t", Value(6)).asInt());
+            ftCfg.put("port", "/ft:i");
+            ftCfg.put("decimation", rf.check("decimation", Value(1)).asInt());
+            if (!addStream("pos", posCfg, verbose) || !addStream("ft", ftCfg, verbose))
+                return false;
+            clockName = "ft";
         }
 
-        if (DAcc<0.0)
+        for (size_t k = 0 ; k < streams.size() ; ++k)
+            if (streams[k]->name == clockName)
+                clockStream = (int)k;
+        if (clockStream < 0)
         {
-            cout<<"Warning: thrAcc cannot be lower than 0.0 => D=0.0 is assumed"<<endl;
-            DAcc=0.0;
+            printf("Error: Clock stream %s not declared!\n", clockName.c_str());
+            return false;
         }
-        
-        // Input positions
-        port_pos = new dataCollector(NVel,DVel,NAcc,DAcc, &PVABuffer, &PVABufferMutex);
-        port_pos->useCallback();
-        port_pos->open((portName + "/pos:i").c_str());
+        clockQueue.resize(bufferLength, streams[clockStream]->outSize);
+        cout << "Output: " << outSize << " values driven by " << clockName << ", maxSkew = " << maxSkew << " s" << endl;
 
-        // Input F/T
-        FTport.open((portName + "/ft:i").c_str());
+        statsPeriod = rf.check("statsPeriod", Value(1.0)).asDouble();
+        if (statsPeriod <= 0.0)
+            statsPeriod = 1.0;
+        lastStatsTime = Time::now();
+        lastClock = clock();
+        lastEmitted = 0;
+
+        // Output Vector
+        outPort.open((portName + "/vec:o").c_str());
+
+        // Input streams
+        for (size_t k = 0 ; k < ports.size() ; ++k)
+            ports[k]->open(portName + streams[k]->port);
         
         // RPC
         rpcPort.open((portName + "/rpc").c_str());
         attach(rpcPort);
-        
-        // Output Vector
-        outPort.open((portName + "/vec:o").c_str());
 
         return true;
     }
 
     virtual bool close()
     {
-        port_pos->close();
-        FTport.close();
+        for (size_t k = 0 ; k < ports.size() ; ++k)
+        {
+            ports[k]->close();
+            delete ports[k];
+        }
+        ports.clear();
         outPort.close();
         rpcPort.close();
 
-        delete port_pos;
-        delete FTVector;
+        for (size_t k = 0 ; k < streams.size() ; ++k)
+            delete streams[k];
+        streams.clear();
 
         return true;
     }
     
     bool interruptModule()
     {
-        port_pos->interrupt();
-        FTport.interrupt();
+        for (size_t k = 0 ; k < ports.size() ; ++k)
+            ports[k]->interrupt();
         outPort.interrupt();
         rpcPort.interrupt();
-        
-        PVABufferMutex.unlock(); // Unlock the mutex to avoid deadlocks and allow a smooth stop
 
+        // Wake up the event loop
+        dataReady.post();
 
         return true;
     }    
 
-    virtual double getPeriod()    { return 0.05;  }
+    // Event loop: wait for the port callbacks
+    virtual double getPeriod()    { return 0.0;  }
     
     virtual bool   updateModule() {
-        
-        cout << "updateModule " << endl;
-        Vector& res = outPort.prepare();
-        res.clear();
-        res.resize(3*xsz + t);
-        
-        // Protect ON
-        PVABufferMutex.lock();
-        res.setSubvector( 0 , PVABuffer );
-        PVABufferMutex.unlock();
-        // Protect OFF
-        
-        // Read the most recent F/T        
-        Bottle* b = FTport.read();
-        for (int i = 0 ; i < b->size() ; i++) {
-            (*FTVector)[i] = b->get(i).asDouble();
-        }
-        
-        if (FTVector==0)
-        {
-            // Skipping...
-            return true;
-        }
-        
-        res.setSubvector( 3*xsz , *FTVector );   // WARNING: FTVector must be the most recent reading of the F/T sensor. How to get it in this callback?
+        dataReady.waitWithTimeout(statsPeriod);
 
-        // the outbound packets will carry the same
-        // envelope information of the inbound ones.
-        if (outPort.getOutputCount()>0)
-        {
-            //outPort.setEnvelope(info);        // WARNING: missing info. To be implemented
-            outPort.write();
-        }
-        else
-            outPort.unprepare();        
-        
+        collect();
+        process();
+        updateStats();
         return true; 
     }
 };
@@ -272,6 +597,21 @@ int main(int argc, char *argv[])
         cout<<"\t--thrVel    D: velocity max deviation threshold (default: 1.0)"    <<endl;
         cout<<"\t--lenAcc    N: acceleration window's max length (default: 25)"     <<endl;
         cout<<"\t--thrAcc    D: acceleration max deviation threshold (default: 1.0)"<<endl;
+        cout<<"\t--derivEstimator E: velocity and acceleration estimator: aw, sg or kalman (default: aw)"<<endl;
+        cout<<"\t--sgLength  N: Savitzky-Golay window length (default: 15)"<<endl;
+        cout<<"\t--sgOrder   P: Savitzky-Golay polynomial order (default: 2)"<<endl;
+        cout<<"\t--kalmanQ   Q: Kalman filter jerk spectral density (default: 1e4)"<<endl;
+        cout<<"\t--kalmanR   R: Kalman filter position measurement variance (default: 1e-3)"<<endl;
+        cout<<"\t--streams (S1 S2 ...): input streams, each configured in its own group (default: positions and F/T)"<<endl;
+        cout<<"\t--clock     S: stream driving the output (default: the last one)"<<endl;
+        cout<<"\t--align     A: alignment to the clock timestamps: nearest, linear or hold (default: linear)"<<endl;
+        cout<<"\t--maxSkew   S: maximum time distance of the aligned samples in s, at least the period of the slowest stream (default: 0.1)"<<endl;
+        cout<<"\t--bufferLength N: timestamped samples buffered per stream (default: 100)"<<endl;
+        cout<<"\t--decimation N: one output sample every N F/T samples (default: 1); with --streams, default decimation of all the streams, overridden in their groups"<<endl;
+        cout<<"\t--joints (J1 J2 ...): indices of the xsz joints used on /pos:i (default: the first xsz)"<<endl;
+        cout<<"\t--posDecimation N: one position sample used every N received (default: 1)"<<endl;
+        cout<<"\t--statsPeriod T: period of the output rate and CPU usage report in s (default: 1.0)"<<endl;
+        cout<<"\t--verbose      : print the received samples"<<endl;
 
         return 0;
     }
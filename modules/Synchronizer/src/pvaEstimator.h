@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _PVA_ESTIMATOR
+#define _PVA_ESTIMATOR
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Value.h>
+#include <yarp/sig/Vector.h>
+
+#include <iCub/ctrl/adaptWinPolyEstimator.h>
+
+/************************************************************************/
+// Causal Savitzky-Golay differentiator: least squares polynomial fit of
+// order 'order' over the last N samples, evaluated at the newest one.
+// The fit is a fixed linear combination of the window, so the coefficients
+// are precomputed once in units of samples and the cost is an O(N) dot
+// product per joint, independent of the data. The window is interleaved
+// (all joints of a sample are contiguous), so the dot products of all the
+// joints are computed together by a loop over the joints, which gcc turns
+// into packed SIMD without reordering any sum. Check with -fopt-info-vec.
+// Samples are assumed uniformly spaced; the sample period is measured over
+// the window.
+class sgDifferentiator
+{
+private:
+    int N;
+    int dim;
+    std::vector<double> cVel;   // Velocity coefficients, oldest sample first [1/sample]
+    std::vector<double> cAcc;   // Acceleration coefficients [1/sample^2]
+    std::vector<double> hist;   // [2N x dim] window, each sample stored in slots s and s+N so that it is always contiguous
+    std::vector<double> times;  // Timestamps of the window, circular
+    int pos;                    // Slot of the newest sample
+    int count;                  // Number of samples received (up to N)
+
+public:
+    sgDifferentiator() : N(0), dim(0), pos(0), count(0)
+    {
+    }
+
+    // Returns false if the window is too short for the polynomial order
+    bool init(int length, int order)
+    {
+        if (order < 2 || length <= order)
+            return false;
+
+        N = length;
+        int m = order + 1;
+
+        // Normal equations A'A of the fit on tau = -(N-1) ... 0
+        std::vector<double> M(m * (2 * m), 0.0);
+        for (int k = 0 ; k < N ; ++k)
+        {
+            double tau = k - (N - 1);
+            for (int i = 0 ; i < m ; ++i)
+                for (int j = 0 ; j < m ; ++j)
+                    M[i * 2 * m + j] += pow(tau, i + j);
+        }
+        for (int i = 0 ; i < m ; ++i)
+            M[i * 2 * m + m + i] = 1.0;
+
+        // Invert A'A by Gauss-Jordan elimination with partial pivoting
+        for (int c = 0 ; c < m ; ++c)
+        {
+            int p = c;
+            for (int r = c + 1 ; r < m ; ++r)
+                if (fabs(M[r * 2 * m + c]) > fabs(M[p * 2 * m + c]))
+                    p = r;
+            for (int j = 0 ; j < 2 * m ; ++j)
+                std::swap(M[c * 2 * m + j], M[p * 2 * m + j]);
+
+            double piv = M[c * 2 * m + c];
+            for (int j = 0 ; j < 2 * m ; ++j)
+                M[c * 2 * m + j] /= piv;
+            for (int r = 0 ; r < m ; ++r)
+            {
+                if (r == c)
+                    continue;
+                double f = M[r * 2 * m + c];
+                for (int j = 0 ; j < 2 * m ; ++j)
+                    M[r * 2 * m + j] -= f * M[c * 2 * m + j];
+            }
+        }
+
+        // Rows 1 and 2 of (A'A)^-1 A' give the first and second derivative at tau = 0
+        cVel.assign(N, 0.0);
+        cAcc.assign(N, 0.0);
+        for (int k = 0 ; k < N ; ++k)
+        {
+            double tau = k - (N - 1);
+            for (int j = 0 ; j < m ; ++j)
+            {
+                cVel[k] += M[1 * 2 * m + m + j] * pow(tau, j);
+                cAcc[k] += 2.0 * M[2 * 2 * m + m + j] * pow(tau, j);
+            }
+        }
+        return true;
+    }
+
+    void estimate(const yarp::sig::Vector &q, double time,
+                  yarp::sig::Vector &qdot, yarp::sig::Vector &qdotdot)
+    {
+        if ((int)q.size() != dim)
+        {
+            dim = (int)q.size();
+            hist.assign(dim * 2 * N, 0.0);
+            times.assign(N, 0.0);
+            pos = N - 1;
+            count = 0;
+        }
+
+        pos = (pos + 1) % N;
+        times[pos] = time;
+        for (int j = 0 ; j < dim ; ++j)
+        {
+            hist[pos * dim + j] = q[j];
+            hist[(pos + N) * dim + j] = q[j];
+        }
+        if (count < N)
+            ++count;
+
+        qdot.resize(dim);
+        qdotdot.resize(dim);
+
+        // No estimate until the window is full
+        double dt = (times[pos] - times[(pos + 1) % N]) / (N - 1);
+        if (count < N || dt <= 0.0)
+        {
+            for (int j = 0 ; j < dim ; ++j)
+                qdot[j] = qdotdot[j] = 0.0;
+            return;
+        }
+
+        double * __restrict v = qdot.data();
+        double * __restrict a = qdotdot.data();
+        for (int j = 0 ; j < dim ; ++j)
+            v[j] = a[j] = 0.0;
+
+        // Window oldest sample first, each sample accumulated into all joints
+        for (int k = 0 ; k < N ; ++k)
+        {
+            const double * __restrict w = &hist[(pos + 1 + k) * dim];
+            double cv = cVel[k], ca = cAcc[k];
+            for (int j = 0 ; j < dim ; ++j)
+            {
+                v[j] += cv * w[j];
+                a[j] += ca * w[j];
+            }
+        }
+
+        double dt2 = dt * dt;
+        for (int j = 0 ; j < dim ; ++j)
+        {
+            v[j] /= dt;
+            a[j] /= dt2;
+        }
+    }
+};
+
+/************************************************************************/
+// Constant acceleration Kalman filter for each joint: state [q, qdot,
+// qdotdot] driven by white jerk of spectral density 'qc', measurements of
+// q with variance 'r'. O(1) per sample, with the actual time elapsed
+// between samples.
+class kalmanDifferentiator
+{
+private:
+    double qc;
+    double r;
+    int dim;
+    std::vector<double> x;      // [dim x 3] states
+    std::vector<double> P;      // [dim x 9] covariances, row-major
+    double lastTime;
+
+public:
+    kalmanDifferentiator() : qc(1e4), r(1e-3), dim(0), lastTime(0.0)
+    {
+    }
+
+    void init(double jerkDensity, double measVariance)
+    {
+        qc = jerkDensity;
+        r = measVariance;
+        dim = 0;
+    }
+
+    void estimate(const yarp::sig::Vector &q, double time,
+                  yarp::sig::Vector &qdot, yarp::sig::Vector &qdotdot)
+    {
+        qdot.resize(q.size());
+        qdotdot.resize(q.size());
+
+        if ((int)q.size() != dim)
+        {
+            // Start from the first measurement, with unknown derivatives
+            dim = (int)q.size();
+            x.assign(dim * 3, 0.0);
+            P.assign(dim * 9, 0.0);
+            for (int j = 0 ; j < dim ; ++j)
+            {
+                x[j * 3] = q[j];
+                P[j * 9 + 0] = r;
+                P[j * 9 + 4] = 1e6;
+                P[j * 9 + 8] = 1e8;
+                qdot[j] = qdotdot[j] = 0.0;
+            }
+            lastTime = time;
+            return;
+        }
+
+        double dt = time - lastTime;
+        lastTime = time;
+        if (dt < 0.0)
+            dt = 0.0;
+
+        // Transition F = [1 dt dt^2/2 ; 0 1 dt ; 0 0 1] and process noise
+        double F[9] = { 1.0, dt, 0.5 * dt * dt, 0.0, 1.0, dt, 0.0, 0.0, 1.0 };
+        double dt2 = dt * dt, dt3 = dt2 * dt;
+        double Q[9] = { dt2 * dt3 / 20.0, dt2 * dt2 / 8.0, dt3 / 6.0,
+                        dt2 * dt2 / 8.0,  dt3 / 3.0,       dt2 / 2.0,
+                        dt3 / 6.0,        dt2 / 2.0,       dt };
+
+        for (int j = 0 ; j < dim ; ++j)
+        {
+            double *xj = &x[j * 3];
+            double *Pj = &P[j * 9];
+
+            // Prediction: x = F x, P = F P F' + qc Q
+            double xp[3];
+            for (int a = 0 ; a < 3 ; ++a)
+                xp[a] = F[a * 3] * xj[0] + F[a * 3 + 1] * xj[1] + F[a * 3 + 2] * xj[2];
+
+            double FP[9];
+            for (int a = 0 ; a < 3 ; ++a)
+                for (int b = 0 ; b < 3 ; ++b)
+                    FP[a * 3 + b] = F[a * 3] * Pj[b] + F[a * 3 + 1] * Pj[3 + b] + F[a * 3 + 2] * Pj[6 + b];
+            for (int a = 0 ; a < 3 ; ++a)
+                for (int b = 0 ; b < 3 ; ++b)
+                    Pj[a * 3 + b] = FP[a * 3] * F[b * 3] + FP[a * 3 + 1] * F[b * 3 + 1] + FP[a * 3 + 2] * F[b * 3 + 2]
+                                    + qc * Q[a * 3 + b];
+
+            // Update with the position measurement, H = [1 0 0]
+            double S = Pj[0] + r;
+            double K[3] = { Pj[0] / S, Pj[3] / S, Pj[6] / S };
+            double innov = q[j] - xp[0];
+            for (int a = 0 ; a < 3 ; ++a)
+                xj[a] = xp[a] + K[a] * innov;
+
+            double P0[3] = { Pj[0], Pj[1], Pj[2] };
+            for (int a = 0 ; a < 3 ; ++a)
+                for (int b = 0 ; b < 3 ; ++b)
+                    Pj[a * 3 + b] -= K[a] * P0[b];
+
+            qdot[j] = xj[1];
+            qdotdot[j] = xj[2];
+        }
+    }
+};
+
+/************************************************************************/
+// Velocity and acceleration estimation from the joint positions, selected
+// by 'derivEstimator':
+//  aw     - adaptive window polynomial fitting (linear for the velocity,
+//           quadratic for the acceleration), cost depending on the data
+//  sg     - Savitzky-Golay differentiator, fixed window
+//  kalman - constant acceleration Kalman filter
+class pvaEstimator
+{
+private:
+    std::string type;
+    iCub::ctrl::AWLinEstimator  *linEst;
+    iCub::ctrl::AWQuadEstimator *quadEst;
+    sgDifferentiator            sg;
+    kalmanDifferentiator        kalman;
+
+public:
+    // Windows lengths and thresholds are read from the configuration of
+    // Synchronizer (lenVel, thrVel, lenAcc, thrAcc for aw; sgLength,
+    // sgOrder for sg; kalmanQ, kalmanR for kalman)
+    pvaEstimator(const yarp::os::Searchable &cfg) : linEst(0), quadEst(0)
+    {
+        type = cfg.check("derivEstimator",yarp::os::Value("aw")).asString().c_str();
+
+        if (type == "sg")
+        {
+            int len = cfg.check("sgLength",yarp::os::Value(15)).asInt();
+            int order = cfg.check("sgOrder",yarp::os::Value(2)).asInt();
+            if (sg.init(len, order))
+                return;
+            std::cout<<"Warning: sgLength must be greater than sgOrder >= 2 => aw estimator is assumed"<<std::endl;
+            type = "aw";
+        }
+        else if (type == "kalman")
+        {
+            kalman.init(cfg.check("kalmanQ",yarp::os::Value(1e4)).asDouble(),
+                        cfg.check("kalmanR",yarp::os::Value(1e-3)).asDouble());
+            return;
+        }
+        else if (type != "aw")
+        {
+            std::cout<<"Warning: unknown derivEstimator "<<type<<" => aw is assumed"<<std::endl;
+            type = "aw";
+        }
+
+        unsigned int NVel=cfg.check("lenVel",yarp::os::Value(16)).asInt();
+        unsigned int NAcc=cfg.check("lenAcc",yarp::os::Value(25)).asInt();
+
+        double DVel=cfg.check("thrVel",yarp::os::Value(1.0)).asDouble();
+        double DAcc=cfg.check("thrAcc",yarp::os::Value(1.0)).asDouble();
+
+        if (NVel<2)
+        {
+            std::cout<<"Warning: lenVel cannot be lower than 2 => N=2 is assumed"<<std::endl;
+            NVel=2;
+        }
+
+        if (NAcc<3)
+        {
+            std::cout<<"Warning: lenAcc cannot be lower than 3 => N=3 is assumed"<<std::endl;
+            NAcc=3;
+        }
+
+        if (DVel<0.0)
+        {
+            std::cout<<"Warning: thrVel cannot be lower than 0.0 => D=0.0 is assumed"<<std::endl;
+            DVel=0.0;
+        }
+
+        if (DAcc<0.0)
+        {
+            std::cout<<"Warning: thrAcc cannot be lower than 0.0 => D=0.0 is assumed"<<std::endl;
+            DAcc=0.0;
+        }
+
+        linEst  = new iCub::ctrl::AWLinEstimator(NVel,DVel);
+        quadEst = new iCub::ctrl::AWQuadEstimator(NAcc,DAcc);
+    }
+
+    ~pvaEstimator()
+    {
+        delete linEst;
+        delete quadEst;
+    }
+
+    const std::string &getType() const
+    {
+        return type;
+    }
+
+    // Estimate the velocity and acceleration at the position sample q
+    // taken at the given time
+    void estimate(const yarp::sig::Vector &q, double time,
+                  yarp::sig::Vector &qdot, yarp::sig::Vector &qdotdot)
+    {
+        if (type == "sg")
+            sg.estimate(q, time, qdot, qdotdot);
+        else if (type == "kalman")
+            kalman.estimate(q, time, qdot, qdotdot);
+        else
+        {
+            iCub::ctrl::AWPolyElement el(q,time);
+            qdot = linEst->estimate(el);
+            qdotdot = quadEst->estimate(el);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _TIMED_BUFFER
+#define _TIMED_BUFFER
+
+#include <string>
+#include <vector>
+
+#include <yarp/sig/Vector.h>
+
+// Policies to align a stream to a given time
+enum alignPolicy
+{
+    ALIGN_NEAREST,      // Sample closest in time
+    ALIGN_LINEAR,       // Linear interpolation between the samples around the time
+    ALIGN_HOLD          // Last sample not newer than the time (causal)
+};
+
+// Results of timedBuffer::align()
+enum alignResult
+{
+    ALIGN_DROP = -1,    // No sample within the maximum skew
+    ALIGN_WAIT = 0,     // A newer sample is needed
+    ALIGN_OK = 1
+};
+
+inline bool parseAlignPolicy(const std::string &name, alignPolicy &policy)
+{
+    if (name == "nearest")
+        policy = ALIGN_NEAREST;
+    else if (name == "linear")
+        policy = ALIGN_LINEAR;
+    else if (name == "hold")
+        policy = ALIGN_HOLD;
+    else
+        return false;
+    return true;
+}
+
+/************************************************************************/
+// Fixed capacity ring of timestamped samples of a stream, ordered by time.
+// When full, the oldest sample is overwritten.
+class timedBuffer
+{
+private:
+    std::vector<double>             times;
+    std::vector<yarp::sig::Vector>  values;
+    int first;      // Index of the oldest sample
+    int count;      // Number of stored samples
+
+    int index(int i) const
+    {
+        return (first + i) % (int)times.size();
+    }
+
+public:
+    timedBuffer() : first(0), count(0)
+    {
+    }
+
+    // Preallocate capacity samples of dim elements
+    void resize(int capacity, int dim)
+    {
+        times.assign(capacity, 0.0);
+        values.assign(capacity, yarp::sig::Vector(dim, 0.0));
+        first = 0;
+        count = 0;
+    }
+
+    int size() const
+    {
+        return count;
+    }
+
+    // Time of the i-th oldest sample
+    double timeAt(int i) const
+    {
+        return times[index(i)];
+    }
+
+    // i-th oldest sample
+    const yarp::sig::Vector &at(int i) const
+    {
+        return values[index(i)];
+    }
+
+    double newestTime() const
+    {
+        return timeAt(count - 1);
+    }
+
+    // Append a sample of n elements. Samples older than the newest one are
+    // out of order and are discarded.
+    bool push(double time, const double *v, int n)
+    {
+        if (count > 0 && time < newestTime())
+            return false;
+
+        int idx;
+        if (count < (int)times.size())
+            idx = index(count++);
+        else
+        {
+            idx = first;
+            first = (first + 1) % (int)times.size();
+        }
+
+        times[idx] = time;
+        yarp::sig::Vector &dst = values[idx];
+        if ((int)dst.size() != n)
+            dst.resize(n);
+        for (int i = 0 ; i < n ; ++i)
+            dst[i] = v[i];
+        return true;
+    }
+
+    void popFront()
+    {
+        if (count > 0)
+        {
+            first = (first + 1) % (int)times.size();
+            --count;
+        }
+    }
+
+    /************************************************************************/
+    // Value of the stream at time t with the given policy. The time distance
+    // between t and the closest sample used must not exceed maxSkew.
+    // The nearest and linear policies need the first sample after t: until
+    // it is received ALIGN_WAIT is returned, unless force is set, in which
+    // case the samples received so far are used.
+    int align(double t, alignPolicy policy, double maxSkew, bool force, yarp::sig::Vector &out) const
+    {
+        // Newest sample not newer than t (a) and the following one (b)
+        int a = count - 1;
+        while (a >= 0 && timeAt(a) > t)
+            --a;
+        int b = a + 1 < count ? a + 1 : -1;
+
+        if (policy != ALIGN_HOLD && b < 0 && !force)
+            return ALIGN_WAIT;
+
+        double skewA = a >= 0 ? t - timeAt(a) : -1.0;
+        double skewB = b >= 0 ? timeAt(b) - t : -1.0;
+
+        if (policy == ALIGN_HOLD || b < 0)
+        {
+            // Causal or no sample after t yet
+            if (a < 0 || skewA > maxSkew)
+                return ALIGN_DROP;
+            out = at(a);
+        }
+        else if (a < 0)
+        {
+            // t precedes the buffered samples
+            if (skewB > maxSkew)
+                return ALIGN_DROP;
+            out = at(b);
+        }
+        else if (policy == ALIGN_NEAREST)
+        {
+            int c = skewA <= skewB ? a : b;
+            if ((c == a ? skewA : skewB) > maxSkew)
+                return ALIGN_DROP;
+            out = at(c);
+        }
+        else
+        {
+            if ((skewA < skewB ? skewA : skewB) > maxSkew)
+                return ALIGN_DROP;
+
+            double w = skewA + skewB > 0.0 ? skewA / (skewA + skewB) : 0.0;
+            const yarp::sig::Vector &va = at(a);
+            const yarp::sig::Vector &vb = at(b);
+            out.resize(va.size());
+            for (size_t i = 0 ; i < va.size() ; ++i)
+                out[i] = va[i] + w * (vb[i] - va[i]);
+        }
+        return ALIGN_OK;
+    }
+};
+
+#endif
@@ -0,0 +1,436 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+// Generates the joint positions and F/T readings of a simulated arm, in place
+// of the state:o and analog:o ports of the robot, to run and stress-test the
+// iRRLS pipeline without the robot or the simulator.
+// The arm is a rigid body chain (see armModel.h) moving through random minimum
+// jerk point to point motions within the joint limits. At each sample the wrench
+// measured by a F/T sensor after the first sensorJoint joints is computed with the
+// Newton-Euler algorithm, so that positions and F/T are consistent. Gaussian noise, a constant
+// F/T bias and a payload changing every payloadPeriod seconds can be added.
+// Both ports carry the same timestamp. The generator thread keeps an absolute
+// schedule, so that rates up to some kHz can be sustained.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <yarp/os/Network.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Thread.h>
+#include <yarp/os/Random.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Vocab.h>
+#include <yarp/sig/Vector.h>
+
+#include "armModel.h"
+#include "lockFree.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+
+#define DEG2RAD (M_PI / 180.0)
+
+/************************************************************************/
+// Read a list of n doubles, or use the default values
+bool getList(const Searchable &rf, const string &key, int n, const vector<double> &def, vector<double> &out)
+{
+    Bottle *b = rf.find(key.c_str()).asList();
+    if (b == 0)
+    {
+        out = def;
+        return true;
+    }
+    if (b->size() != n)
+    {
+        printf("Error: %s must contain %d values!\n", key.c_str(), n);
+        return false;
+    }
+    out.resize(n);
+    for (int i = 0 ; i < n ; ++i)
+        out[i] = b->get(i).asDouble();
+    return true;
+}
+
+/************************************************************************/
+class generatorThread : public Thread
+{
+private:
+    BufferedPort<Vector>   *statePort;
+    BufferedPort<Vector>   *ftPort;
+    armModel                arm;
+    minJerkSegment          segment;
+    double                  segmentStart;
+
+    int                     dof;
+    int                     stateSize;      // Size of the state vector, at least dof
+    double                  period;         // [s]
+    vector<double>          jointMin, jointMax;         // [rad]
+    double                  minDuration, maxDuration;   // Durations of the motions [s]
+    double                  posNoise;       // [deg]
+    double                  forceNoise, torqueNoise;
+    vector<double>          ftBias;
+    double                  payloadMax;     // [kg]
+    double                  payloadPeriod;  // [s], 0 for a constant payload
+    double                  lastPayloadChange;
+
+    vector<double>          q, qd, qdd, target;
+    double                  ft[6];
+    Stamp                   stamp;
+
+    void newSegment(double now)
+    {
+        for (int j = 0 ; j < dof ; ++j)
+            target[j] = jointMin[j] + Random::uniform() * (jointMax[j] - jointMin[j]);
+        segment.set(q, target, minDuration + Random::uniform() * (maxDuration - minDuration));
+        segmentStart = now;
+    }
+
+public:
+    // Statistics and payload, shared with the rpc thread of the module
+    // through relaxed atomics
+    double                  payload;        // [kg]
+    long unsigned int       samples;
+    double                  maxLate;        // Maximum delay on the schedule [s]
+    double                  startTime;
+
+    generatorThread(BufferedPort<Vector> *sp, BufferedPort<Vector> *fp)
+        : statePort(sp), ftPort(fp), segmentStart(0.0), dof(0), stateSize(0), period(0.01),
+          minDuration(1.0), maxDuration(3.0), posNoise(0.0), forceNoise(0.0), torqueNoise(0.0),
+          payloadMax(0.0), payloadPeriod(0.0), lastPayloadChange(0.0),
+          payload(0.0), samples(0), maxLate(0.0), startTime(0.0)
+    {
+    }
+
+    bool configure(ResourceFinder &rf)
+    {
+        dof = rf.check("dof",Value(4)).asInt();
+        if (dof <= 0)
+        {
+            printf("Error: dof must be positive!\n");
+            return false;
+        }
+        stateSize = rf.check("stateSize",Value(16)).asInt();
+        if (stateSize < dof)
+            stateSize = dof;
+        double rate = rf.check("rate",Value(100.0)).asDouble();
+        if (rate <= 0.0)
+        {
+            printf("Error: rate must be positive!\n");
+            return false;
+        }
+        period = 1.0 / rate;
+
+        // Default geometry: spherical shoulder, upper arm and forearm as on
+        // the iCub, then short links with alternating axes
+        vector<double> defA(dof), defD(dof), defAlpha(dof), defMass(dof), defMin(dof), defMax(dof);
+        for (int j = 0 ; j < dof ; ++j)
+        {
+            defA[j] = j == 3 ? 0.137 : (j > 3 ? 0.05 : 0.0);
+            defD[j] = j == 2 ? 0.15 : 0.0;
+            defAlpha[j] = j % 2 == 0 ? -90.0 : 90.0;
+            defMass[j] = j < 2 ? 0.1 : (j == 2 ? 1.0 : (j == 3 ? 0.8 : 0.2));
+            defMin[j] = -60.0;
+            defMax[j] = 60.0;
+        }
+        defMin[0] = -90.0;  defMax[0] = 0.0;
+        if (dof > 1) { defMin[1] = 10.0;  defMax[1] = 100.0; }
+        if (dof > 3) { defMin[3] = 20.0;  defMax[3] = 100.0; }
+
+        vector<double> A, D, alpha, mass;
+        if (!getList(rf, "a", dof, defA, A) || !getList(rf, "d", dof, defD, D) ||
+            !getList(rf, "alpha", dof, defAlpha, alpha) || !getList(rf, "mass", dof, defMass, mass) ||
+            !getList(rf, "jointMin", dof, defMin, jointMin) || !getList(rf, "jointMax", dof, defMax, jointMax) ||
+            !getList(rf, "ftBias", 6, vector<double>(6, 0.0), ftBias))
+            return false;
+        for (int j = 0 ; j < dof ; ++j)
+        {
+            alpha[j] *= DEG2RAD;
+            jointMin[j] *= DEG2RAD;
+            jointMax[j] *= DEG2RAD;
+        }
+
+        int sensorJoint = rf.check("sensorJoint",Value(dof < 3 ? dof - 1 : 2)).asInt();
+        if (sensorJoint < 0 || sensorJoint >= dof)
+        {
+            printf("Error: sensorJoint must be between 0 and dof - 1!\n");
+            return false;
+        }
+        arm.configure(A, D, alpha, mass, sensorJoint);
+
+        minDuration = rf.check("minDuration",Value(1.0)).asDouble();
+        maxDuration = rf.check("maxDuration",Value(3.0)).asDouble();
+        if (minDuration <= 0.0 || maxDuration < minDuration)
+        {
+            printf("Error: Inconsistent motion durations!\n");
+            return false;
+        }
+        posNoise = rf.check("posNoise",Value(0.01)).asDouble();
+        forceNoise = rf.check("forceNoise",Value(0.1)).asDouble();
+        torqueNoise = rf.check("torqueNoise",Value(0.01)).asDouble();
+        payload = rf.check("payload",Value(0.0)).asDouble();
+        payloadMax = rf.check("payloadMax",Value(0.5)).asDouble();
+        payloadPeriod = rf.check("payloadPeriod",Value(0.0)).asDouble();
+        Random::seed(rf.check("seed",Value(1)).asInt());
+
+        // Start at rest in the middle of the joint ranges
+        q.resize(dof);
+        qd.assign(dof, 0.0);
+        qdd.assign(dof, 0.0);
+        target.resize(dof);
+        for (int j = 0 ; j < dof ; ++j)
+            q[j] = 0.5 * (jointMin[j] + jointMax[j]);
+
+        cout << endl << "-------------------------" << endl;
+        cout << "dof = " << dof << ", stateSize = " << stateSize << ", sensorJoint = " << sensorJoint << endl;
+        cout << "rate = " << rate << " Hz" << endl;
+        cout << "motions of " << minDuration << " to " << maxDuration << " s" << endl;
+        cout << "posNoise = " << posNoise << " deg, forceNoise = " << forceNoise << ", torqueNoise = " << torqueNoise << endl;
+        cout << "payload = " << payload << " kg";
+        if (payloadPeriod > 0.0)
+            cout << ", changed every " << payloadPeriod << " s up to " << payloadMax << " kg";
+        cout << endl << "-------------------------" << endl << endl;
+        return true;
+    }
+
+    void run()
+    {
+        double start = Time::now();
+        atomicSet(startTime, start);
+        lastPayloadChange = start;
+        newSegment(start);
+        double next = start;
+
+        while (!isStopping())
+        {
+            // Absolute schedule: a late sample does not delay the following ones,
+            // unless the generator falls behind by more than 10 periods
+            next += period;
+            double wait = next - Time::now();
+            if (wait > 0.0)
+                Time::delay(wait);
+            else
+            {
+                if (-wait > maxLate)
+                    atomicSet(maxLate, -wait);
+                if (-wait > 10.0 * period)
+                    next = Time::now();
+            }
+
+            double now = Time::now();
+            if (now - segmentStart > segment.length())
+                newSegment(now);
+            segment.evaluate(now - segmentStart, &q[0], &qd[0], &qdd[0]);
+
+            if (payloadPeriod > 0.0 && now - lastPayloadChange > payloadPeriod)
+            {
+                atomicSet(payload, Random::uniform() * payloadMax);
+                lastPayloadChange = now;
+            }
+            arm.wrench(&q[0], &qd[0], &qdd[0], atomicGet(payload), ft);
+
+            stamp.update(now);
+
+            Vector &state = statePort->prepare();
+            state.resize(stateSize);
+            for (int j = 0 ; j < stateSize ; ++j)
+                state[j] = j < dof ? q[j] / DEG2RAD + posNoise * Random::normal() : 0.0;
+            statePort->setEnvelope(stamp);
+            statePort->write();
+
+            Vector &FT = ftPort->prepare();
+            FT.resize(6);
+            for (int i = 0 ; i < 6 ; ++i)
+                FT[i] = ft[i] + ftBias[i] + (i < 3 ? forceNoise : torqueNoise) * Random::normal();
+            ftPort->setEnvelope(stamp);
+            ftPort->write();
+
+            atomicIncrement(samples);
+        }
+    }
+};
+
+/************************************************************************/
+class SyntheticArm: public RFModule
+{
+protected:
+
+    // Ports
+    BufferedPort<Vector>  statePort;    // Joint positions [deg], as state:o of the robot
+    BufferedPort<Vector>  ftPort;       // [ F , T ], as analog:o of the F/T sensor
+    Port                  rpcPort;
+
+    generatorThread      *generator;
+
+public:
+    /************************************************************************/
+    SyntheticArm() : generator(0)
+    {
+    }
+
+    // rpcPort commands handler
+    bool respond(const Bottle &      command,
+                 Bottle &      reply)
+    {
+        string receivedCmd = command.get(0).asString().c_str();
+        reply.clear();
+
+        if (receivedCmd == "help")
+        {
+            reply.addVocab(Vocab::encode("many"));
+            reply.addString("Available commands are:");
+            reply.addString("help");
+            reply.addString("stats");
+            reply.addString("payload <kg>");
+            reply.addString("quit");
+        }
+        else if (receivedCmd == "stats")
+        {
+            double elapsed = Time::now() - atomicGet(generator->startTime);
+            long unsigned int samples = atomicGet(generator->samples);
+            reply.addString("samples");
+            reply.addInt((int)samples);
+            reply.addString("rate");
+            reply.addDouble(elapsed > 0.0 ? samples / elapsed : 0.0);
+            reply.addString("maxLate");
+            reply.addDouble(atomicGet(generator->maxLate));
+            reply.addString("payload");
+            reply.addDouble(atomicGet(generator->payload));
+        }
+        else if (receivedCmd == "payload")
+        {
+            if (command.size() > 1 && command.get(1).asDouble() >= 0.0)
+            {
+                atomicSet(generator->payload, command.get(1).asDouble());
+                reply.addString("Payload set.");
+            }
+            else
+                reply.addString("Usage: payload <kg>, not negative.");
+        }
+        else if (receivedCmd == "quit")
+        {
+            reply.addString("Quitting.");
+            return false;
+        }
+        else
+            reply.addString("Invalid command, type [help] for a list of accepted commands.");
+
+        return true;
+    }
+
+    bool configure(ResourceFinder &rf)
+    {
+        string name=rf.find("name").asString().c_str();
+        setName(name.c_str());
+
+        // request high resolution scheduling
+        Time::turboBoost();
+
+        generator = new generatorThread(&statePort, &ftPort);
+        if (!generator->configure(rf))
+            return false;
+
+        // Open ports
+        string fwslash="/";
+        statePort.open((fwslash+name+"/state:o").c_str());
+        ftPort.open((fwslash+name+"/analog:o").c_str());
+        rpcPort.open((fwslash+name+"/rpc:i").c_str());
+
+        // Attach rpcPort to the respond() method
+        attach(rpcPort);
+
+        if (!generator->start())
+        {
+            printf("Error: Could not start the generator thread!\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    /************************************************************************/
+    bool close()
+    {
+        if (generator != 0)
+        {
+            generator->stop();
+            double elapsed = Time::now() - generator->startTime;
+            cout << "Generated " << generator->samples << " samples in " << elapsed << " s";
+            if (elapsed > 0.0)
+                cout << " (" << generator->samples / elapsed << " samples/s)";
+            cout << ", maximum delay on schedule " << 1000.0 * generator->maxLate << " ms" << endl;
+            delete generator;
+            generator = 0;
+        }
+
+        statePort.close();
+        ftPort.close();
+        rpcPort.close();
+
+        return true;
+    }
+
+    /************************************************************************/
+    double getPeriod()
+    {
+        return 1.0;
+    }
+
+    /************************************************************************/
+    bool updateModule()
+    {
+        return true;
+    }
+
+    /************************************************************************/
+    bool interruptModule()
+    {
+        statePort.interrupt();
+        ftPort.interrupt();
+        rpcPort.interrupt();
+        return true;
+    }
+};
+
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    Network yarp;
+    if (!yarp.checkNetwork())
+    {
+        printf("YARP server not available!\n");
+        return -1;
+    }
+
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultConfigFile("SyntheticArm_config.ini");
+    rf.setDefaultContext("iRRLS");
+    rf.setDefault("name","SyntheticArm");
+    rf.configure(argc,argv);
+
+    SyntheticArm mod;
+    return mod.runModule(rf);
+}
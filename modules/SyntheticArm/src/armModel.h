@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _ARM_MODEL
+#define _ARM_MODEL
+
+#include <vector>
+#include <cmath>
+
+/************************************************************************/
+// Minimal 3D vector algebra for the dynamics computations, on the stack
+struct vec3
+{
+    double x, y, z;
+
+    vec3() : x(0.0), y(0.0), z(0.0) {}
+    vec3(double a, double b, double c) : x(a), y(b), z(c) {}
+
+    vec3 operator+(const vec3 &v) const { return vec3(x + v.x, y + v.y, z + v.z); }
+    vec3 operator-(const vec3 &v) const { return vec3(x - v.x, y - v.y, z - v.z); }
+    vec3 operator*(double s) const      { return vec3(x * s, y * s, z * s); }
+
+    vec3 cross(const vec3 &v) const
+    {
+        return vec3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x);
+    }
+};
+
+// Rotation matrix, row major
+struct rot3
+{
+    double m[3][3];
+
+    rot3()
+    {
+        for (int i = 0 ; i < 3 ; ++i)
+            for (int j = 0 ; j < 3 ; ++j)
+                m[i][j] = i == j ? 1.0 : 0.0;
+    }
+
+    vec3 operator*(const vec3 &v) const
+    {
+        return vec3(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                    m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                    m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+    }
+
+    rot3 operator*(const rot3 &r) const
+    {
+        rot3 out;
+        for (int i = 0 ; i < 3 ; ++i)
+            for (int j = 0 ; j < 3 ; ++j)
+                out.m[i][j] = m[i][0] * r.m[0][j] + m[i][1] * r.m[1][j] + m[i][2] * r.m[2][j];
+        return out;
+    }
+
+    // Transpose times v
+    vec3 transposeTimes(const vec3 &v) const
+    {
+        return vec3(m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z,
+                    m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z,
+                    m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z);
+    }
+
+    vec3 column(int j) const
+    {
+        return vec3(m[0][j], m[1][j], m[2][j]);
+    }
+};
+
+/************************************************************************/
+// Rigid body serial arm of revolute joints, described by standard
+// Denavit-Hartenberg parameters. Each link is a uniform rod between the
+// origins of its frame and of the previous one, so that its center of
+// mass and inertia follow from the geometry and its mass. A point payload
+// is attached to the origin of the last frame.
+// wrench() computes, with the recursive Newton-Euler algorithm, the
+// force and moment which the links up to the sensor exert on the rest of
+// the arm, as measured by a F/T sensor placed after the first sensorJoint
+// joints and expressed in the frame of the last of them (the base frame
+// if sensorJoint is 0). The base z axis points up.
+class armModel
+{
+private:
+    struct link
+    {
+        double a, d, alpha, offset;
+        double mass;
+        vec3   com;         // Center of mass in the link frame
+        double inertia;     // Rotational inertia about the center of mass (isotropic approximation)
+    };
+
+    std::vector<link> links;
+    int sensorJoint;
+    double gravity;
+
+    // Per-joint quantities in the base frame, preallocated
+    std::vector<rot3> R;    // Orientation of frame i (R[0]: base)
+    std::vector<vec3> p;    // Origin of frame i
+    std::vector<vec3> w, wd, a, ac;
+
+public:
+    armModel() : sensorJoint(0), gravity(9.81)
+    {
+    }
+
+    // Set up n links from the DH parameters [m, rad] and the link masses [kg]
+    void configure(const std::vector<double> &A, const std::vector<double> &D, const std::vector<double> &alpha,
+                   const std::vector<double> &mass, int sensor)
+    {
+        int n = (int)A.size();
+        links.resize(n);
+        for (int i = 0 ; i < n ; ++i)
+        {
+            link &l = links[i];
+            l.a = A[i];
+            l.d = D[i];
+            l.alpha = alpha[i];
+            l.offset = 0.0;
+            l.mass = mass[i];
+
+            // The previous origin is at -(a, d sin(alpha), d cos(alpha)) in the link frame
+            l.com = vec3(l.a, l.d * sin(l.alpha), l.d * cos(l.alpha)) * -0.5;
+            double L2 = l.a * l.a + l.d * l.d;
+            l.inertia = l.mass * (L2 / 12.0 + 0.0005);     // Rod of radius ~4.5 cm
+        }
+        sensorJoint = sensor;
+
+        R.resize(n + 1);
+        p.resize(n + 1);
+        w.resize(n + 1);
+        wd.resize(n + 1);
+        a.resize(n + 1);
+        ac.resize(n + 1);
+    }
+
+    int dof() const
+    {
+        return (int)links.size();
+    }
+
+    // Wrench [ F , T ] at the sensor for the joint positions, velocities and
+    // accelerations q, qd, qdd [rad, rad/s, rad/s^2], with the given payload [kg]
+    void wrench(const double *q, const double *qd, const double *qdd, double payload, double *ft)
+    {
+        int n = dof();
+
+        // Forward recursion: kinematics and accelerations, gravity as a base acceleration
+        w[0] = vec3();
+        wd[0] = vec3();
+        a[0] = vec3(0.0, 0.0, gravity);
+        for (int i = 1 ; i <= n ; ++i)
+        {
+            const link &l = links[i - 1];
+            double th = q[i - 1] + l.offset;
+            double ct = cos(th), st = sin(th), ca = cos(l.alpha), sa = sin(l.alpha);
+
+            rot3 Ri;    // Rz(th) Rx(alpha)
+            Ri.m[0][0] = ct;  Ri.m[0][1] = -st * ca;  Ri.m[0][2] = st * sa;
+            Ri.m[1][0] = st;  Ri.m[1][1] = ct * ca;   Ri.m[1][2] = -ct * sa;
+            Ri.m[2][0] = 0.0; Ri.m[2][1] = sa;        Ri.m[2][2] = ca;
+
+            vec3 z = R[i - 1].column(2);    // Axis of joint i
+            R[i] = R[i - 1] * Ri;
+            vec3 r = R[i - 1] * vec3(l.a * ct, l.a * st, l.d);
+            p[i] = p[i - 1] + r;
+
+            w[i] = w[i - 1] + z * qd[i - 1];
+            wd[i] = wd[i - 1] + z * qdd[i - 1] + w[i - 1].cross(z) * qd[i - 1];
+            a[i] = a[i - 1] + wd[i].cross(r) + w[i].cross(w[i].cross(r));
+
+            vec3 rc = R[i] * l.com;
+            ac[i] = a[i] + wd[i].cross(rc) + w[i].cross(w[i].cross(rc));
+        }
+
+        // Backward recursion: force and moment (about the previous origin)
+        // exerted on each link by the previous one, down to the sensor
+        vec3 f = a[n] * payload;
+        vec3 m;
+        for (int i = n ; i > sensorJoint ; --i)
+        {
+            const link &l = links[i - 1];
+            vec3 r = p[i] - p[i - 1];
+            vec3 rc = r + R[i] * l.com;
+            vec3 fi = ac[i] * l.mass;
+
+            // Isotropic inertia: I wd + w x (I w) = I wd
+            m = m + r.cross(f) + rc.cross(fi) + wd[i] * l.inertia;
+            f = f + fi;
+        }
+
+        // In the sensor frame
+        vec3 fs = R[sensorJoint].transposeTimes(f);
+        vec3 ms = R[sensorJoint].transposeTimes(m);
+        ft[0] = fs.x;   ft[1] = fs.y;   ft[2] = fs.z;
+        ft[3] = ms.x;   ft[4] = ms.y;   ft[5] = ms.z;
+    }
+};
+
+/************************************************************************/
+// Minimum jerk point to point motion of each joint, starting and ending at rest
+class minJerkSegment
+{
+private:
+    std::vector<double> q0, qf;
+    double duration;
+
+public:
+    minJerkSegment() : duration(1.0)
+    {
+    }
+
+    void set(const std::vector<double> &from, const std::vector<double> &to, double T)
+    {
+        q0 = from;
+        qf = to;
+        duration = T;
+    }
+
+    double length() const
+    {
+        return duration;
+    }
+
+    // Position, velocity and acceleration at time t from the start
+    void evaluate(double t, double *q, double *qd, double *qdd) const
+    {
+        double tau = t / duration;
+        if (tau < 0.0) tau = 0.0;
+        if (tau > 1.0) tau = 1.0;
+        double tau2 = tau * tau, tau3 = tau2 * tau;
+        double s = tau3 * (10.0 - 15.0 * tau + 6.0 * tau2);
+        double sd = tau2 * (30.0 - 60.0 * tau + 30.0 * tau2) / duration;
+        double sdd = tau * (60.0 - 180.0 * tau + 120.0 * tau2) / (duration * duration);
+        for (size_t j = 0 ; j < q0.size() ; ++j)
+        {
+            double delta = qf[j] - q0[j];
+            q[j] = q0[j] + s * delta;
+            qd[j] = sd * delta;
+            qdd[j] = sdd * delta;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _JOINT_SELECTOR
+#define _JOINT_SELECTOR
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include <yarp/os/Port.h>
+#include <yarp/os/PortReader.h>
+#include <yarp/os/ConnectionReader.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+
+#include "wireVector.h"
+#include "lockFree.h"
+
+/************************************************************************/
+// Input port which keeps one message every 'decimation' and decodes only
+// the selected elements of it, e.g. some joints of the state:o port of a
+// robot part. It replaces the signalsMask.lua port monitor: the messages
+// are decoded straight from the connection into storage preallocated in
+// configure(), skipped messages are not decoded at all, and selected
+// samples are passed to onSelected() in the port thread together with
+// their timestamp (the local time if the sender does not attach one).
+// Vectors, Bottles of ints and Bottles of mixed numbers are accepted.
+class jointSelector : public yarp::os::PortReader
+{
+private:
+    yarp::os::Port              port;
+    std::vector<int>            joints;     // Indices of the selected elements
+    int                         decimation;
+    int                         numDecoded; // Elements decoded from each message
+    std::vector<double>         scratch;    // Decoded elements
+    yarp::sig::Vector           selected;
+    yarp::os::Stamp             info;
+    long unsigned int           received;
+    long unsigned int           errors;     // Messages too short or not made of numbers
+
+    bool decode(yarp::os::ConnectionReader &connection)
+    {
+        connection.convertTextMode();
+        int header = connection.expectInt();
+        int len = connection.expectInt();
+        if (len < numDecoded)
+            return false;
+
+        if (header == (BOTTLE_TAG_LIST | BOTTLE_TAG_DOUBLE))
+        {
+            // Raw doubles: the elements after the last selected one are left unread
+            if (!connection.expectBlock((char*)&scratch[0], numDecoded * sizeof(double)))
+                return false;
+        }
+        else if (header == (BOTTLE_TAG_LIST | BOTTLE_TAG_INT))
+        {
+            for (int i = 0 ; i < numDecoded ; ++i)
+                scratch[i] = connection.expectInt();
+        }
+        else if (header == BOTTLE_TAG_LIST)
+        {
+            for (int i = 0 ; i < numDecoded ; ++i)
+            {
+                int tag = connection.expectInt();
+                if (tag == BOTTLE_TAG_DOUBLE)
+                    scratch[i] = connection.expectDouble();
+                else if (tag == BOTTLE_TAG_INT)
+                    scratch[i] = connection.expectInt();
+                else
+                    return false;
+            }
+        }
+        else
+            return false;
+
+        return !connection.isError();
+    }
+
+protected:
+    // Called in the port thread for every selected message
+    virtual void onSelected(double time, const yarp::sig::Vector &x) = 0;
+
+public:
+    jointSelector() : decimation(1), numDecoded(0), received(0), errors(0)
+    {
+    }
+
+    virtual ~jointSelector()
+    {
+    }
+
+    // Select the elements of the given indices, one message every decim
+    bool configure(const std::vector<int> &indices, int decim)
+    {
+        if (indices.empty() || decim < 1)
+            return false;
+
+        joints = indices;
+        decimation = decim;
+        numDecoded = 0;
+        for (size_t i = 0 ; i < joints.size() ; ++i)
+        {
+            if (joints[i] < 0)
+                return false;
+            if (joints[i] + 1 > numDecoded)
+                numDecoded = joints[i] + 1;
+        }
+        scratch.assign(numDecoded, 0.0);
+        selected.resize(joints.size(), 0.0);
+        return true;
+    }
+
+    bool open(const std::string &name)
+    {
+        port.setReader(*this);
+        return port.open(name.c_str());
+    }
+
+    void interrupt()
+    {
+        port.interrupt();
+    }
+
+    void close()
+    {
+        port.close();
+    }
+
+    int size() const
+    {
+        return (int)joints.size();
+    }
+
+    // Messages discarded because they could not be decoded
+    long unsigned int decodeErrors() const
+    {
+        return atomicGet(errors);
+    }
+
+    virtual bool read(yarp::os::ConnectionReader &connection)
+    {
+        if (received++ % decimation != 0)
+            return true;
+
+        if (!decode(connection))
+        {
+            if (__atomic_fetch_add(&errors, 1, __ATOMIC_RELAXED) == 0)
+                printf("Error: Message on %s does not contain %d numbers!\n", port.getName().c_str(), numDecoded);
+            return false;
+        }
+
+        for (size_t i = 0 ; i < joints.size() ; ++i)
+            selected[i] = scratch[joints[i]];
+
+        port.getEnvelope(info);
+        double time = info.isValid()?info.getTime():yarp::os::Time::now();
+        onSelected(time, selected);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _LOCK_FREE
+#define _LOCK_FREE
+
+#include <vector>
+
+#include <yarp/sig/Vector.h>
+
+/************************************************************************/
+// Wait-free single-producer/single-consumer queue of timestamped vectors,
+// to hand samples from a port callback to another thread without locks.
+// Each side only writes its own index and publishes it with release
+// semantics, so neither side can be blocked by the other: when the queue
+// is full push() fails and the sample is lost.
+class spscTimedQueue
+{
+private:
+    std::vector<double>             times;
+    std::vector<yarp::sig::Vector>  values;
+    unsigned int capacity;      // Power of 2
+    unsigned int head;          // Next slot written by the producer
+    unsigned int tail;          // Next slot read by the consumer
+
+public:
+    spscTimedQueue() : capacity(0), head(0), tail(0)
+    {
+    }
+
+    // Preallocate at least numSlots samples of dim elements.
+    // Not thread safe, to be called before the queue is used.
+    void resize(int numSlots, int dim)
+    {
+        for (capacity = 1 ; capacity < (unsigned int)numSlots ; capacity *= 2) ;
+        times.assign(capacity, 0.0);
+        values.assign(capacity, yarp::sig::Vector(dim, 0.0));
+        head = 0;
+        tail = 0;
+    }
+
+    // Producer side
+    bool push(double time, const double *v, int n)
+    {
+        unsigned int h = head;
+        if (h - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= capacity)
+            return false;
+
+        unsigned int idx = h & (capacity - 1);
+        times[idx] = time;
+        yarp::sig::Vector &dst = values[idx];
+        if ((int)dst.size() != n)
+            dst.resize(n);
+        for (int i = 0 ; i < n ; ++i)
+            dst[i] = v[i];
+
+        __atomic_store_n(&head, h + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Consumer side: front() and frontTime() are valid while empty() is false
+    bool empty() const
+    {
+        return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == tail;
+    }
+
+    double frontTime() const
+    {
+        return times[tail & (capacity - 1)];
+    }
+
+    const yarp::sig::Vector &front() const
+    {
+        return values[tail & (capacity - 1)];
+    }
+
+    void pop()
+    {
+        __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+    }
+};
+
+/************************************************************************/
+// Wait-free triple buffer holding the latest timestamped state written by
+// one thread and read by another. The writer fills its back buffer and
+// swaps it with the middle one; the reader swaps the middle buffer with
+// its front one only if a newer state was published. Both operations are
+// a single atomic exchange, so the two sides never wait for each other
+// and the reader always sees a complete state.
+class tripleBuffer
+{
+private:
+    yarp::sig::Vector   buf[3];
+    double              stamp[3];
+    int                 back;       // Written by the writer
+    int                 front;      // Read by the reader
+    int                 middle;     // Shared: buffer index | FRESH
+
+    enum { FRESH = 4 };
+
+public:
+    tripleBuffer() : back(0), front(2), middle(1)
+    {
+        stamp[0] = stamp[1] = stamp[2] = 0.0;
+    }
+
+    // Not thread safe, to be called before the buffer is used
+    void resize(int dim)
+    {
+        for (int i = 0 ; i < 3 ; ++i)
+        {
+            buf[i].resize(dim, 0.0);
+            stamp[i] = 0.0;
+        }
+        back = 0;
+        middle = 1;
+        front = 2;
+    }
+
+    // Writer side: fill writeBuffer(), then publish() it
+    yarp::sig::Vector &writeBuffer()
+    {
+        return buf[back];
+    }
+
+    void publish(double time)
+    {
+        stamp[back] = time;
+        back = __atomic_exchange_n(&middle, back | FRESH, __ATOMIC_ACQ_REL) & ~FRESH;
+    }
+
+    // Reader side: make the latest published state available in latest().
+    // Returns false if nothing new was published since the last call.
+    bool update()
+    {
+        if (!(__atomic_load_n(&middle, __ATOMIC_ACQUIRE) & FRESH))
+            return false;
+        front = __atomic_exchange_n(&middle, front, __ATOMIC_ACQ_REL) & ~FRESH;
+        return true;
+    }
+
+    const yarp::sig::Vector &latest() const
+    {
+        return buf[front];
+    }
+
+    double latestTime() const
+    {
+        return stamp[front];
+    }
+};
+
+/************************************************************************/
+// Statistics and settings shared between a worker thread and the rpc
+// thread of a module: plain loads and stores would be a data race, these
+// are relaxed atomics, which for 8 byte values compile to plain moves.
+template <class T>
+inline T atomicGet(const T &value)
+{
+    T v;
+    __atomic_load(&value, &v, __ATOMIC_RELAXED);
+    return v;
+}
+
+template <class T>
+inline void atomicSet(T &value, T v)
+{
+    __atomic_store(&value, &v, __ATOMIC_RELAXED);
+}
+
+// Counter incremented by a single thread, or by several ones
+inline void atomicIncrement(long unsigned int &counter)
+{
+    __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _SAMPLE_FILE
+#define _SAMPLE_FILE
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+#include <yarp/sig/Vector.h>
+
+/************************************************************************/
+// Load the samples of a space, tab or comma separated text file, as used by
+// the offline evaluators. Lines with fewer than numCols values are skipped.
+inline bool loadSamples(const std::string &fileName, int numCols, std::vector<yarp::sig::Vector> &samples)
+{
+    std::ifstream ifs(fileName.c_str());
+    if (!ifs.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        for (size_t i = 0 ; i < line.size() ; ++i)
+            if (line[i] == ',')
+                line[i] = ' ';
+
+        std::istringstream iss(line);
+        yarp::sig::Vector sample(numCols);
+        int col = 0;
+        while (col < numCols && iss >> sample[col])
+            ++col;
+
+        if (col == numCols)
+            samples.push_back(sample);
+    }
+    return true;
+}
+
+#endif
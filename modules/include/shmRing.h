@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _SHM_RING
+#define _SHM_RING
+
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+/************************************************************************/
+// Shared memory header of the ring. The producer and consumer indices
+// are kept on separate cache lines, so that the two processes do not
+// invalidate each other's line at every message.
+struct shmRingHeader
+{
+    volatile int magic;             // Set by the consumer once the ring is initialized
+    int capacity;                   // Number of slots, power of 2
+    int slotDoubles;                // Maximum number of doubles per message
+    volatile int closed;            // Set by the consumer when it goes away
+    char pad0[64];
+    volatile unsigned int head;     // Next slot written by the producer
+    volatile int dataSeq;           // Futex word, incremented at every message
+    volatile int dataWaiters;       // The consumer sleeps on dataSeq
+    char pad1[64];
+    volatile unsigned int tail;     // Next slot read by the consumer
+    volatile int spaceSeq;          // Futex word, incremented at every freed slot
+    volatile int spaceWaiters;      // The producer sleeps on spaceSeq
+    char pad2[64];
+};
+
+/************************************************************************/
+// Single-producer/single-consumer ring of vectors of doubles in POSIX
+// shared memory, for pipeline stages running on the same host.
+// Messages are copied once into the ring and once out of it; the indices
+// are published with memory barriers, and a side only enters the kernel
+// (futex wait/wake) when it has to sleep on an empty or full ring, or has
+// to wake up the other side which is sleeping.
+// The consumer owns the segment: it creates it in openConsumer() and
+// marks it closed in close(). The producer attaches lazily in write(), so
+// the two modules can be started in any order; messages written while no
+// consumer is attached are dropped, as on an unconnected port.
+class shmRingChannel
+{
+private:
+    std::string     name;
+    bool            consumer;
+    int             capacity;
+    int             slotDoubles;
+    size_t          mapSize;
+    shmRingHeader  *hdr;
+    char           *slots;
+    double          timeout;        // Maximum time blocked on a full ring [s]
+    double          lastAttempt;    // Time of the last attach attempt of the producer
+    volatile bool   interrupted;
+
+    size_t slotBytes() const
+    {
+        return sizeof(double) * (slotDoubles + 1);  // Length, then the doubles
+    }
+
+    double *slotData(unsigned int idx) const
+    {
+        return (double*)(slots + (idx & (capacity - 1)) * slotBytes());
+    }
+
+#ifdef __linux__
+    static void futexWait(volatile int *addr, int val, double seconds)
+    {
+        struct timespec ts;
+        ts.tv_sec = (time_t)seconds;
+        ts.tv_nsec = (long)((seconds - ts.tv_sec) * 1e9);
+        syscall(SYS_futex, (int*)addr, FUTEX_WAIT, val, &ts, NULL, 0);
+    }
+
+    static void futexWake(volatile int *addr)
+    {
+        syscall(SYS_futex, (int*)addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+
+    bool map(int fd)
+    {
+        void *p = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return false;
+        hdr = (shmRingHeader*)p;
+        slots = (char*)p + sizeof(shmRingHeader);
+        return true;
+    }
+
+    // Attach the producer to a ring created by the consumer
+    bool attach()
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shmRingHeader))
+        {
+            ::close(fd);
+            return false;
+        }
+        mapSize = st.st_size;
+        if (!map(fd))
+            return false;
+
+        // The layout is decided by the consumer
+        __sync_synchronize();
+        capacity = hdr->capacity;
+        slotDoubles = hdr->slotDoubles;
+        if (hdr->magic != magicNumber() || hdr->closed ||
+            mapSize != sizeof(shmRingHeader) + capacity * slotBytes())
+        {
+            detach();
+            return false;
+        }
+        printf("Attached to shared memory ring %s: %d slots of %d doubles\n", name.c_str(), capacity, slotDoubles);
+        return true;
+    }
+
+    void detach()
+    {
+        if (hdr != 0)
+            munmap((void*)hdr, mapSize);
+        hdr = 0;
+        slots = 0;
+    }
+#endif
+
+    static int magicNumber()
+    {
+        return 0x52524c53;
+    }
+
+public:
+    shmRingChannel() : consumer(false), capacity(0), slotDoubles(0), mapSize(0), hdr(0), slots(0),
+                       timeout(1.0), lastAttempt(0.0), interrupted(false)
+    {
+    }
+
+    ~shmRingChannel()
+    {
+        close();
+    }
+
+    // True once the channel has been configured on either side
+    bool isActive() const
+    {
+        return name != "";
+    }
+
+    // Create the ring, removing any segment left over by a previous run.
+    // Capacity is rounded up to a power of 2.
+    bool openConsumer(const std::string &ringName, int numSlots, int maxDoubles)
+    {
+#ifdef __linux__
+        name = "/" + ringName;
+        consumer = true;
+        for (capacity = 1 ; capacity < numSlots ; capacity *= 2) ;
+        slotDoubles = maxDoubles;
+        mapSize = sizeof(shmRingHeader) + capacity * slotBytes();
+
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 || ftruncate(fd, mapSize) != 0)
+        {
+            printf("Error: Could not create shared memory ring %s: %s\n", name.c_str(), strerror(errno));
+            if (fd >= 0)
+                ::close(fd);
+            name = "";
+            return false;
+        }
+        if (!map(fd))
+        {
+            printf("Error: Could not map shared memory ring %s\n", name.c_str());
+            shm_unlink(name.c_str());
+            name = "";
+            return false;
+        }
+
+        memset((void*)hdr, 0, sizeof(shmRingHeader));
+        hdr->capacity = capacity;
+        hdr->slotDoubles = slotDoubles;
+        __sync_synchronize();
+        hdr->magic = magicNumber();
+        printf("Shared memory ring %s created: %d slots of %d doubles\n", name.c_str(), capacity, slotDoubles);
+        return true;
+#else
+        printf("Error: Shared memory rings are only available on Linux\n");
+        return false;
+#endif
+    }
+
+    // Set up the producer side. The ring is attached at the first write
+    // after the consumer has created it, with the consumer's layout.
+    bool openProducer(const std::string &ringName, double maxBlock)
+    {
+#ifdef __linux__
+        name = "/" + ringName;
+        consumer = false;
+        timeout = maxBlock;
+        attach();
+        return true;
+#else
+        printf("Error: Shared memory rings are only available on Linux\n");
+        return false;
+#endif
+    }
+
+    // Write a message of n doubles. Blocks up to the configured timeout
+    // while the ring is full, so that no sample is dropped while the
+    // consumer is alive.
+    bool write(const double *x, int n)
+    {
+#ifdef __linux__
+        if (hdr != 0 && hdr->closed)
+        {
+            printf("Consumer of shared memory ring %s closed\n", name.c_str());
+            detach();
+        }
+        if (hdr == 0)
+        {
+            // Do not retry the attach at every message
+            double now = yarp::os::Time::now();
+            if (now - lastAttempt < 0.5)
+                return false;
+            lastAttempt = now;
+            if (!attach())
+                return false;
+        }
+
+        if (n > slotDoubles)
+        {
+            printf("Error: Message of %d elements exceeds the ring slots (%d)!\n", n, slotDoubles);
+            return false;
+        }
+
+        unsigned int head = hdr->head;
+        double t0 = yarp::os::Time::now();
+        while (head - hdr->tail >= (unsigned int)capacity)
+        {
+            if (interrupted || hdr->closed || yarp::os::Time::now() - t0 > timeout)
+                return false;
+
+            // Announce the wait before checking the ring again, so that
+            // the consumer cannot free a slot without waking us up
+            int seq = hdr->spaceSeq;
+            hdr->spaceWaiters = 1;
+            __sync_synchronize();
+            if (head - hdr->tail >= (unsigned int)capacity)
+                futexWait(&hdr->spaceSeq, seq, 0.1);
+            hdr->spaceWaiters = 0;
+        }
+
+        double *slot = slotData(head);
+        slot[0] = n;
+        memcpy(slot + 1, x, n * sizeof(double));
+
+        // Publish the message, then wake up the consumer if it is sleeping
+        __sync_synchronize();
+        hdr->head = head + 1;
+        __sync_fetch_and_add(&hdr->dataSeq, 1);
+        if (hdr->dataWaiters)
+            futexWake(&hdr->dataSeq);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Number of messages waiting in the ring
+    int pending() const
+    {
+        if (hdr == 0)
+            return 0;
+        __sync_synchronize();
+        return (int)(hdr->head - hdr->tail);
+    }
+
+    // Read the next message into v. If wait is true, blocks until a
+    // message arrives or interrupt() is called.
+    bool read(yarp::sig::Vector &v, bool wait = true)
+    {
+#ifdef __linux__
+        if (hdr == 0)
+            return false;
+
+        unsigned int tail = hdr->tail;
+        while (hdr->head == tail)
+        {
+            if (!wait || interrupted)
+                return false;
+
+            int seq = hdr->dataSeq;
+            hdr->dataWaiters = 1;
+            __sync_synchronize();
+            if (hdr->head == tail)
+                futexWait(&hdr->dataSeq, seq, 0.5);
+            hdr->dataWaiters = 0;
+        }
+        __sync_synchronize();
+
+        const double *slot = slotData(tail);
+        int n = (int)slot[0];
+        v.resize(n);
+        if (n > 0)
+            memcpy(v.data(), slot + 1, n * sizeof(double));
+
+        // Free the slot, then wake up the producer if it is sleeping
+        __sync_synchronize();
+        hdr->tail = tail + 1;
+        __sync_fetch_and_add(&hdr->spaceSeq, 1);
+        if (hdr->spaceWaiters)
+            futexWake(&hdr->spaceSeq);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Unblock any pending read or write
+    void interrupt()
+    {
+        interrupted = true;
+#ifdef __linux__
+        if (hdr != 0)
+        {
+            __sync_fetch_and_add(consumer ? &hdr->dataSeq : &hdr->spaceSeq, 1);
+            futexWake(consumer ? &hdr->dataSeq : &hdr->spaceSeq);
+        }
+#endif
+    }
+
+    void close()
+    {
+#ifdef __linux__
+        if (hdr != 0 && consumer)
+        {
+            hdr->closed = 1;
+            __sync_synchronize();
+            futexWake(&hdr->spaceSeq);
+            shm_unlink(name.c_str());
+        }
+        detach();
+#endif
+        name = "";
+    }
+};
+
+#endif
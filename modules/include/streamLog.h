@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _STREAM_LOG
+#define _STREAM_LOG
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+#include <yarp/sig/Vector.h>
+
+#include "lockFree.h"
+
+/************************************************************************/
+// Binary log of a stream of timestamped vectors, e.g. Synchronizer/vec:o.
+// <base>.log starts with a header and is followed by the records, each
+// made of a streamLogRecord and its n doubles, in native byte order.
+// <base>.idx holds a streamLogIndex entry per record, so that a replay
+// can start anywhere and know the length of the log without scanning it.
+// Both files are only appended to; a record is indexed after it has been
+// written, and a log whose index is missing or shorter (e.g. after a
+// crash) is indexed again by scanning it. Appending to an existing log
+// rewrites its complete index first.
+struct streamLogHeader
+{
+    char magic[8];          // "iRRLSlog"
+    int  version;
+    int  reserved;
+};
+
+struct streamLogRecord
+{
+    double stamp;           // Envelope time of the message (sender clock)
+    double arrival;         // Time at which the recorder received it
+    int    n;               // Number of doubles following the record
+    int    reserved;
+};
+
+struct streamLogIndex
+{
+    double arrival;
+    long long offset;       // Position of the record in the log
+};
+
+inline const char *streamLogMagic()
+{
+    return "iRRLSlog";
+}
+
+/************************************************************************/
+class streamLogReader
+{
+private:
+    FILE *logFile;
+    std::vector<streamLogIndex> index;
+    int next;                   // Record returned by the next read()
+    long long validEnd;         // End of the last complete record
+    long long fileEnd;
+
+    // Index the records of the log which are not in the index file
+    void scan(long long end)
+    {
+        long long offset = index.empty() ? (long long)sizeof(streamLogHeader) : index.back().offset;
+        streamLogRecord r;
+        validEnd = offset;
+
+        if (!index.empty())
+        {
+            // Skip the last indexed record
+            fseek(logFile, (long)offset, SEEK_SET);
+            if (fread(&r, sizeof(r), 1, logFile) != 1 || r.n < 0 ||
+                offset + (long long)(sizeof(r) + r.n * sizeof(double)) > end)
+            {
+                index.pop_back();
+                return;
+            }
+            offset += sizeof(r) + r.n * sizeof(double);
+            validEnd = offset;
+        }
+
+        while (offset + (long long)sizeof(r) <= end)
+        {
+            fseek(logFile, (long)offset, SEEK_SET);
+            if (fread(&r, sizeof(r), 1, logFile) != 1 || r.n < 0 ||
+                offset + (long long)(sizeof(r) + r.n * sizeof(double)) > end)
+                break;      // Truncated record
+            streamLogIndex e;
+            e.arrival = r.arrival;
+            e.offset = offset;
+            index.push_back(e);
+            offset += sizeof(r) + r.n * sizeof(double);
+            validEnd = offset;
+        }
+    }
+
+public:
+    streamLogReader() : logFile(0), next(0), validEnd(0), fileEnd(0)
+    {
+    }
+
+    ~streamLogReader()
+    {
+        close();
+    }
+
+    bool open(const std::string &base)
+    {
+        std::string logName = base + ".log";
+        logFile = fopen(logName.c_str(), "rb");
+        if (logFile == 0)
+        {
+            printf("Error: Could not open %s!\n", logName.c_str());
+            return false;
+        }
+
+        streamLogHeader h;
+        if (fread(&h, sizeof(h), 1, logFile) != 1 || memcmp(h.magic, streamLogMagic(), sizeof(h.magic)) != 0 || h.version != 1)
+        {
+            printf("Error: %s is not a stream log!\n", logName.c_str());
+            close();
+            return false;
+        }
+        fseek(logFile, 0, SEEK_END);
+        long long end = ftell(logFile);
+        fileEnd = end;
+
+        // Load the index, then index any record it misses
+        index.clear();
+        FILE *idxFile = fopen((base + ".idx").c_str(), "rb");
+        if (idxFile != 0)
+        {
+            streamLogIndex e;
+            while (fread(&e, sizeof(e), 1, idxFile) == 1 && e.offset < end)
+                index.push_back(e);
+            fclose(idxFile);
+        }
+        size_t indexed = index.size();
+        scan(end);
+        if (validEnd < fileEnd)
+            printf("Warning: %s ends with a truncated record\n", logName.c_str());
+        if (index.size() > indexed)
+            printf("Warning: %d records of %s were not indexed\n", (int)(index.size() - indexed), logName.c_str());
+
+        seek(0);
+        return true;
+    }
+
+    void close()
+    {
+        if (logFile != 0)
+            fclose(logFile);
+        logFile = 0;
+        index.clear();
+    }
+
+    int size() const
+    {
+        return (int)index.size();
+    }
+
+    // True if the log ends with a complete record
+    bool complete() const
+    {
+        return validEnd == fileEnd;
+    }
+
+    const std::vector<streamLogIndex> &entries() const
+    {
+        return index;
+    }
+
+    // Arrival time of the i-th record
+    double arrival(int i) const
+    {
+        return index[i].arrival;
+    }
+
+    // First record received at time t or later
+    int find(double t) const
+    {
+        int lo = 0, hi = (int)index.size();
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (index[mid].arrival < t)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    void seek(int i)
+    {
+        atomicSet(next, i);
+        if (logFile != 0 && i < (int)index.size())
+            fseek(logFile, (long)index[i].offset, SEEK_SET);
+    }
+
+    int tell() const
+    {
+        return atomicGet(next);
+    }
+
+    // Read the next record. x is only reallocated if the size changes.
+    bool read(double &stamp, double &arrival, yarp::sig::Vector &x)
+    {
+        if (logFile == 0 || next >= (int)index.size())
+            return false;
+
+        streamLogRecord r;
+        if (fread(&r, sizeof(r), 1, logFile) != 1)
+            return false;
+        if ((int)x.size() != r.n)
+            x.resize(r.n);
+        if (r.n > 0 && fread(x.data(), sizeof(double), r.n, logFile) != (size_t)r.n)
+            return false;
+
+        stamp = r.stamp;
+        arrival = r.arrival;
+        atomicSet(next, next + 1);
+        return true;
+    }
+};
+
+/************************************************************************/
+class streamLogWriter
+{
+private:
+    FILE *logFile;
+    FILE *idxFile;
+    long long offset;           // End of the log
+    long unsigned int records;
+
+public:
+    streamLogWriter() : logFile(0), idxFile(0), offset(0), records(0)
+    {
+    }
+
+    ~streamLogWriter()
+    {
+        close();
+    }
+
+    // Create the log, or append to it if append is set and it exists
+    bool open(const std::string &base, bool append)
+    {
+        std::string logName = base + ".log";
+        std::string idxName = base + ".idx";
+
+        FILE *existing = append ? fopen(logName.c_str(), "rb") : 0;
+        if (existing != 0)
+        {
+            fclose(existing);
+
+            // Check the log and rewrite its index, which may miss records
+            streamLogReader reader;
+            if (!reader.open(base))
+                return false;
+            if (!reader.complete())
+            {
+                printf("Error: Cannot append to %s, it ends with a truncated record!\n", logName.c_str());
+                return false;
+            }
+            idxFile = fopen(idxName.c_str(), "wb");
+            if (idxFile != 0 && reader.size() > 0)
+                fwrite(&reader.entries()[0], sizeof(streamLogIndex), reader.size(), idxFile);
+
+            logFile = fopen(logName.c_str(), "ab");
+            if (logFile != 0)
+            {
+                fseek(logFile, 0, SEEK_END);
+                offset = ftell(logFile);
+            }
+        }
+        else
+            logFile = fopen(logName.c_str(), "wb");
+
+        if (logFile == 0)
+        {
+            printf("Error: Could not open %s!\n", logName.c_str());
+            close();
+            return false;
+        }
+
+        if (offset == 0)
+        {
+            streamLogHeader h;
+            memset(&h, 0, sizeof(h));
+            memcpy(h.magic, streamLogMagic(), sizeof(h.magic));
+            h.version = 1;
+            fwrite(&h, sizeof(h), 1, logFile);
+            offset = sizeof(h);
+            idxFile = fopen(idxName.c_str(), "wb");
+        }
+
+        if (idxFile == 0)
+        {
+            printf("Error: Could not open %s!\n", idxName.c_str());
+            close();
+            return false;
+        }
+
+        // Large buffers, the records are flushed in blocks
+        setvbuf(logFile, 0, _IOFBF, 1 << 20);
+        records = 0;
+        return true;
+    }
+
+    bool isOpen() const
+    {
+        return logFile != 0;
+    }
+
+    bool write(double stamp, double arrival, const double *x, int n)
+    {
+        if (logFile == 0)
+            return false;
+
+        streamLogRecord r;
+        r.stamp = stamp;
+        r.arrival = arrival;
+        r.n = n;
+        r.reserved = 0;
+        streamLogIndex e;
+        e.arrival = arrival;
+        e.offset = offset;
+
+        if (fwrite(&r, sizeof(r), 1, logFile) != 1 ||
+            (n > 0 && fwrite(x, sizeof(double), n, logFile) != (size_t)n) ||
+            fwrite(&e, sizeof(e), 1, idxFile) != 1)
+            return false;
+
+        // Published atomically, count() and bytes() are read by other threads
+        atomicSet(offset, offset + (long long)(sizeof(r) + n * sizeof(double)));
+        atomicIncrement(records);
+        return true;
+    }
+
+    // Records written since open()
+    long unsigned int count() const
+    {
+        return atomicGet(records);
+    }
+
+    long long bytes() const
+    {
+        return atomicGet(offset);
+    }
+
+    void flush()
+    {
+        if (logFile != 0)
+            fflush(logFile);
+        if (idxFile != 0)
+            fflush(idxFile);
+    }
+
+    void close()
+    {
+        if (logFile != 0)
+            fclose(logFile);
+        if (idxFile != 0)
+            fclose(idxFile);
+        logFile = 0;
+        idxFile = 0;
+        offset = 0;
+    }
+};
+
+#endif
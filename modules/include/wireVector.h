@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2014 iCub Facility - Istituto Italiano di Tecnologia
+ * Author: Raffaello Camoriano
+ * email: raffaello.camoriano@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef _WIRE_VECTOR
+#define _WIRE_VECTOR
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Portable.h>
+#include <yarp/os/ConnectionReader.h>
+#include <yarp/os/ConnectionWriter.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
+
+#ifndef BOTTLE_TAG_INT
+#define BOTTLE_TAG_INT 1
+#endif
+#ifndef BOTTLE_TAG_DOUBLE
+#define BOTTLE_TAG_DOUBLE (2+8)
+#endif
+#ifndef BOTTLE_TAG_LIST
+#define BOTTLE_TAG_LIST 256
+#endif
+
+/************************************************************************/
+// Serialization time of the wireVector messages read and written by
+// the process, for the 'stats' rpc command of the modules. The port
+// threads only add to the counters with relaxed atomics, and time one
+// message out of WIRE_STATS_SAMPLING, so that collecting the statistics
+// costs neither a lock nor a clock read per message.
+#define WIRE_STATS_SAMPLING 64      // Power of 2
+
+struct wireStats
+{
+    long unsigned int readCount;
+    long unsigned int writeCount;
+    long unsigned int compatCount;  // Messages decoded element by element
+    long unsigned int readTimeNs;   // Total time of the timed reads [ns]
+    long unsigned int writeTimeNs;  // Total time of the timed writes [ns]
+
+    wireStats() : readCount(0), writeCount(0), compatCount(0), readTimeNs(0), writeTimeNs(0)
+    {
+    }
+
+    static void add(long unsigned int &counter, long unsigned int n)
+    {
+        __atomic_fetch_add(&counter, n, __ATOMIC_RELAXED);
+    }
+
+    static long unsigned int get(const long unsigned int &counter)
+    {
+        return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+    }
+
+    // True for the messages to time, given the count before the message
+    static bool sampled(long unsigned int count)
+    {
+        return (count & (WIRE_STATS_SAMPLING - 1)) == 0;
+    }
+
+    static long unsigned int toNs(double t)
+    {
+        return t > 0.0 ? (long unsigned int)(t * 1e9) : 0;
+    }
+
+    // Add the average read and write times to a reply bottle
+    void report(yarp::os::Bottle &reply) const
+    {
+        long unsigned int reads = get(readCount), writes = get(writeCount);
+        long unsigned int timedReads = (reads + WIRE_STATS_SAMPLING - 1) / WIRE_STATS_SAMPLING;
+        long unsigned int timedWrites = (writes + WIRE_STATS_SAMPLING - 1) / WIRE_STATS_SAMPLING;
+        reply.addString("avgReadTime");
+        reply.addDouble(timedReads > 0 ? 1e-9 * get(readTimeNs) / timedReads : 0.0);
+        reply.addString("avgWriteTime");
+        reply.addDouble(timedWrites > 0 ? 1e-9 * get(writeTimeNs) / timedWrites : 0.0);
+        reply.addString("compatReads");
+        reply.addInt((int)get(compatCount));
+    }
+};
+
+inline wireStats &getWireStats()
+{
+    static wireStats stats;
+    return stats;
+}
+
+/************************************************************************/
+// Vector of doubles exchanged between the pipeline stages.
+// It is written as a header plus the raw doubles in a single block, the
+// same encoding of a yarp::sig::Vector or of a Bottle containing only
+// doubles, so readers expecting either keep working. Reading also accepts
+// generic Bottles of numbers (e.g. containing ints, or sent in text mode),
+// which are converted element by element.
+class wireVector : public yarp::os::Portable
+{
+public:
+    yarp::sig::Vector data;
+
+    int size() const
+    {
+        return (int)data.size();
+    }
+
+    bool read(yarp::os::ConnectionReader &connection)
+    {
+        wireStats &stats = getWireStats();
+        bool timed = wireStats::sampled(__atomic_fetch_add(&stats.readCount, 1, __ATOMIC_RELAXED));
+        double t0 = timed ? yarp::os::Time::now() : 0.0;
+        bool compat = false;
+
+        connection.convertTextMode();
+        int header = connection.expectInt();
+        int len = connection.expectInt();
+        if (len < 0)
+            return false;
+        data.resize(len);
+
+        bool ok = true;
+        if (header == (BOTTLE_TAG_LIST | BOTTLE_TAG_DOUBLE))
+        {
+            // Raw doubles, a single copy
+            if (len > 0)
+                ok = connection.expectBlock((char*)data.data(), len * sizeof(double));
+        }
+        else if (header == (BOTTLE_TAG_LIST | BOTTLE_TAG_INT))
+        {
+            compat = true;
+            for (int i = 0 ; i < len ; ++i)
+                data[i] = connection.expectInt();
+        }
+        else if (header == BOTTLE_TAG_LIST)
+        {
+            // Compatibility with Bottles of mixed numbers: tag and value of each element
+            compat = true;
+            for (int i = 0 ; i < len && ok ; ++i)
+            {
+                int tag = connection.expectInt();
+                if (tag == BOTTLE_TAG_DOUBLE)
+                    data[i] = connection.expectDouble();
+                else if (tag == BOTTLE_TAG_INT)
+                    data[i] = connection.expectInt();
+                else
+                    ok = false;
+            }
+        }
+        else
+            ok = false;
+
+        if (compat)
+            wireStats::add(stats.compatCount, 1);
+        if (timed)
+            wireStats::add(stats.readTimeNs, wireStats::toNs(yarp::os::Time::now() - t0));
+
+        return ok && !connection.isError();
+    }
+
+    bool write(yarp::os::ConnectionWriter &connection)
+    {
+        wireStats &stats = getWireStats();
+        bool timed = wireStats::sampled(__atomic_fetch_add(&stats.writeCount, 1, __ATOMIC_RELAXED));
+        double t0 = timed ? yarp::os::Time::now() : 0.0;
+
+        connection.appendInt(BOTTLE_TAG_LIST | BOTTLE_TAG_DOUBLE);
+        connection.appendInt((int)data.size());
+        connection.appendExternalBlock((const char*)data.data(), data.size() * sizeof(double));
+
+        // If the connection is in text mode, convert the message
+        connection.convertTextMode();
+
+        if (timed)
+            wireStats::add(stats.writeTimeNs, wireStats::toNs(yarp::os::Time::now() - t0));
+
+        return !connection.isError();
+    }
+};
+
+#endif
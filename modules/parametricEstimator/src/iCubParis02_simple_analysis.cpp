@@ -25,8 +25,10 @@
 
 
 #include <fstream>
+#include <vector>
 
 #include <yarp/os/Property.h>
+#include <yarp/os/Time.h>
 
 #include "multitaskRecursiveLinearEstimator.h"
 #include "multitaskSVDLinearEstimator.h"
@@ -137,6 +139,44 @@ bool toEigen(const yarp::sig::Vector & vec_yrp, Eigen::VectorXd & vec_eigen)
     }
 }
 
+/**
+ * Compare the update of the Cholesky decomposition of the estimator with m rank-1 updates
+ * (one per output) and with a single blocked rank-m update, on n_iter random regressors
+ * of the given size. Prints the time per sample and the difference of the two results.
+ */
+void benchmarkRankUpdate(int n, int m, int n_iter, double lambda)
+{
+    std::vector<Eigen::MatrixXd> regressors(n_iter);
+    for(int i=0; i < n_iter; i++ ) {
+        regressors[i] = Eigen::MatrixXd::Random(n,m);
+    }
+
+    Eigen::LDLT<Eigen::MatrixXd> loop_ldlt(lambda*Eigen::MatrixXd::Identity(n,n));
+    double loop_time = yarp::os::Time::now();
+    for(int i=0; i < n_iter; i++ ) {
+        for(int out=0; out < m; out++ ) {
+            loop_ldlt.rankUpdate(regressors[i].col(out));
+        }
+    }
+    loop_time = yarp::os::Time::now() - loop_time;
+
+    blockLDLT block_ldlt(n);
+    block_ldlt.compute(lambda*Eigen::MatrixXd::Identity(n,n));
+    double block_time = yarp::os::Time::now();
+    for(int i=0; i < n_iter; i++ ) {
+        block_ldlt.blockRankUpdate(regressors[i]);
+    }
+    block_time = yarp::os::Time::now() - block_time;
+
+    Eigen::MatrixXd loop_A = loop_ldlt.reconstructedMatrix();
+    double rel_diff = (block_ldlt.reconstructedMatrix()-loop_A).norm()/loop_A.norm();
+
+    cout << "Benchmark of the update of the decomposition, n = " << n << ", m = " << m << ", " << n_iter << " samples" << endl;
+    cout << "    " << m << " rank-1 updates: " << 1e6*loop_time/n_iter << " us/sample" << endl;
+    cout << "    rank-" << m << " update:   " << 1e6*block_time/n_iter << " us/sample" << endl;
+    cout << "    speedup " << loop_time/block_time << ", relative difference of the results " << rel_diff << endl;
+}
+
 typedef double T;
 
 int main(int argc, char ** argv)
@@ -154,6 +194,7 @@ int main(int argc, char ** argv)
         cout << "additional options: --lambda regularization parameter" << std::endl;
         cout << "additional options: --skip number of initial samples to skip" << std::endl;
         cout << "additional options: --verbose print debug information" << std::endl;
+        cout << "additional options: --benchmark n_iter compare the rank-1 and rank-m updates of the estimator on n_iter random samples" << std::endl;
         cout << "additional options: --parameters param.csv output a file of trajectoreis of the estimated parameters" << std::endl;
         return 0;
     }
@@ -584,6 +625,10 @@ int main(int argc, char ** argv)
     output_stddev << 0.0707119 ,  0.07460326,  0.11061799,  0.00253377,  0.00295331, 0.00281101;
    
    
+    if( opt.check("benchmark") ) {
+        benchmarkRankUpdate(nrOfBase_parameters,ft_regressor_generator.getNrOfOutputs(),opt.find("benchmark").asInt(),lambda);
+    }
+
     //Defining the estimator objects
     multiTaskRecursiveLinearEstimator estimator_dynamic(nrOfBase_parameters,ft_regressor_generator.getNrOfOutputs(),lambda);
     estimator_dynamic.setOutputErrorStandardDeviation(output_stddev);
@@ -17,11 +17,71 @@
 
 #include "multitaskRecursiveLinearEstimator.h"
 #include <cstdio>
+#include <cmath>
+#include <limits>
 #include <iostream>
 
 using namespace std;
 using namespace Eigen;
 
+/*************************************************************************************************/
+///< w -= a*l and then l += g*w, in a single pass over the entries of the column l of the factor:
+///< the entries are processed in fixed-size chunks, vectorized by Eigen and kept in registers
+///< between the two operations
+static void updateColumn(double *w, double *l, int len, double a, double g)
+{
+    typedef Eigen::Map<Eigen::Array<double,8,1> > chunk;
+    int i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        chunk wc(w+i), lc(l+i);
+        wc -= a*lc;
+        lc += g*wc;
+    }
+    for (; i < len; i++)
+    {
+        w[i] -= a*l[i];
+        l[i] += g*w[i];
+    }
+}
+
+/*************************************************************************************************/
+void blockLDLT::blockRankUpdate(const MatrixXd &Wnew)
+{
+    assert(m_isInitialized && Wnew.rows() == m_matrix.rows());
+    const int size = (int)m_matrix.rows();
+    const int m = (int)Wnew.cols();
+
+    ///< same steps as m calls of rankUpdate(), with the loops over the columns of the factor
+    ///< and over the update vectors swapped: the update of column j by vector r only depends
+    ///< on the updates of column j by the previous vectors and on the columns before j, so
+    ///< column j stays in cache while it is updated by all the vectors
+    Wp = m_transpositions * Wnew;
+    alpha.setOnes(m);
+    for (int j = 0; j < size; j++)
+    {
+        const int rs = size - j - 1;
+        double *Lj = &m_matrix.coeffRef(0,j);
+        for (int r = 0; r < m; r++)
+        {
+            ///< the update of a vector terminates on an original decomposition of low rank
+            if (!(std::abs(alpha(r)) <= std::numeric_limits<double>::max()))
+                continue;
+
+            double dj = Lj[j];
+            double wj = Wp.coeff(j,r);
+            double swj2 = wj*wj;
+            double gamma = dj*alpha(r) + swj2;
+
+            Lj[j] += swj2/alpha(r);
+            alpha(r) += swj2/dj;
+
+            updateColumn(&Wp.coeffRef(j+1,r), Lj+j+1, rs, wj, gamma != 0 ? wj/gamma : 0.0);
+        }
+    }
+}
+
+/*************************************************************************************************/
 multiTaskRecursiveLinearEstimator::multiTaskRecursiveLinearEstimator(unsigned int nParam, unsigned int nOutputs, double lambda) 
     : n(nParam), m(nOutputs), R(n), sampleCount(0)
 { 
@@ -32,14 +92,11 @@ multiTaskRecursiveLinearEstimator::multiTaskRecursiveLinearEstimator(unsigned in
 void multiTaskRecursiveLinearEstimator::feedSample(const MatrixXd &input, const VectorXd &output)
 {
     assert(checkDomainCoDomainSizes(input,output));
-    for(int out=0; out < m; out++ ) {
-        ///< update the Cholesky decomposition of the inverse covariance matrix
-        assert(input.row(out).transpose().rows() == R.rows());
-        assert((input.row(out)/sigma_oe(out)).transpose().rows() == R.rows());
-        R.rankUpdate(input.row(out).transpose()/sigma_oe(out));
-        ///< update the right hand side of the equation
-        b += input.row(out)*(output(out)/(sigma_oe(out)*sigma_oe(out)));
-    }
+    ///< update the Cholesky decomposition of the inverse covariance matrix with all the output rows at once
+    W = (input.array().colwise() / sigma_oe.array()).matrix().transpose();
+    R.blockRankUpdate(W);
+    ///< update the right hand side of the equation
+    b += W * (output.array() / sigma_oe.array()).matrix();
     sampleCount++;
 }
 
@@ -21,6 +21,27 @@
 #include <Eigen/Core>                               // import most common Eigen types
 #include <Eigen/Cholesky>
 
+/** LDLT decomposition with a blocked rank-m update.
+ * Updating \f$ A \f$ with the \f$ m \f$ rows of a sample by m successive rank-1 updates sweeps
+ * the whole factor m times. blockRankUpdate() performs the same m updates column by column of
+ * the factor, so that each column is updated by all the rows while in cache, and each update
+ * is a single pass over the column. The result is the same as m calls of rankUpdate(), in the
+ * same order.
+ */
+class blockLDLT : public Eigen::LDLT<Eigen::MatrixXd>
+{
+protected:
+    Eigen::MatrixXd     Wp;     ///< Permuted update vectors
+    Eigen::VectorXd     alpha;  ///< Running scaling of each update vector
+
+public:
+    blockLDLT(int size = 0) : Eigen::LDLT<Eigen::MatrixXd>(size) {}
+
+    /** Rank-m update \f$ A + W W^T \f$ of the decomposed matrix.
+     * @param W The n x m matrix of the update vectors. */
+    void blockRankUpdate(const Eigen::MatrixXd &W);
+};
+
 /** Class for performing online (i.e. recursive) estimation of parameters
  * according to a linear model of the form:
  * \f[
@@ -41,8 +62,8 @@
  * To avoid storing all the samples in memory the estimator only need to store \f$ A_t \in R^{n \times n}\f$
  * and \f$ b_t \in R^n\f$, which have constant size. Actually, to improve the numerical accuracy
  * of the estimation, the Cholesky decomposition of \f$ A_t \f$ is stored, which is a triangular matrix
- * \f$ R_t \in R^{n \times n} \f$ such that \f$ A_t = R_t^T R_t \f$. A rank-1 update rule is used to
- * incrementally update the Cholesky decomposition.
+ * \f$ R_t \in R^{n \times n} \f$ such that \f$ A_t = R_t^T R_t \f$. A rank-m update rule is used to
+ * incrementally update the Cholesky decomposition with the m rows of each sample.
  */
 class multiTaskRecursiveLinearEstimator
 {
@@ -50,7 +71,8 @@ protected:
     unsigned int                    n;      ///< The number of parameters
     unsigned int                    m;      ///< The number of outputs
     Eigen::VectorXd          sigma_oe;      ///< Standard deviation of the outputs (default: 1)
-    Eigen::LDLT<Eigen::MatrixXd>    R;      ///< Cholesky factor of the inverse covariance matrix (i.e. A).
+    blockLDLT                       R;      ///< Cholesky factor of the inverse covariance matrix (i.e. A).
+    Eigen::MatrixXd                 W;      ///< Weighted regressor of the current sample, transposed
     Eigen::VectorXd                 x;      ///< current parameter estimate
     Eigen::VectorXd                 b;      ///< current projected output
     int                     sampleCount;    ///< Number of samples during last training routine